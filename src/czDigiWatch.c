@@ -1,306 +1,964 @@
 #include <pebble.h>
-#include "namedays-cs.h"
+#include "locale-pack.h"
+#include "icon-atlas.auto.h"
+#include "message-queue.h"
+#include "weather-schedule.h"
+#include "instrument.h"
+#include "energy-stats.h"
+#include "worker-snapshot.h"
 
 static Window *s_main_window;
-static TextLayer *main_digits;
-static TextLayer *seconds;
-static TextLayer *day_in_week;
-static TextLayer *date;
-static TextLayer *nameday1_line;
-static TextLayer *nameday2_line;
-static TextLayer *now_layer;
-static TextLayer *tomorrow_layer;
-static TextLayer *temperature_layer;
-static TextLayer *temperature_next_layer;
-static BitmapLayer *icon_layer;
-static BitmapLayer *icon_next_layer;
-static GBitmap *icon_bitmap = NULL;
-static GBitmap *icon_bitmap_next = NULL;
-static BitmapLayer *battery_layer;
-static GBitmap *icon_battery = NULL;
-static TextLayer *battery_percent_layer;
+static Layer *canvas_layer;
+// Všechny ikony v jednom obrázku, oblasti z něj kreslí výřezy
+static GBitmap *icon_atlas;
+
+// Oblasti ciferníku, všechny kreslí jediná vrstva canvas_layer
+typedef enum {
+  REGION_DIGITS,
+  REGION_SECONDS,
+  REGION_DAY_IN_WEEK,
+  REGION_DATE,
+  REGION_NAMEDAY1,
+  REGION_NAMEDAY2,
+  REGION_ICON,
+  REGION_TEMPERATURE,
+  REGION_ICON_NEXT,
+  REGION_TEMPERATURE_NEXT,
+  REGION_NOW,
+  REGION_TOMORROW,
+  REGION_BATTERY,
+  REGION_BATTERY_PERCENT,
+  REGION_COUNT
+} Region;
+
+typedef struct {
+  GRect frame;
+  const char *font;
+  GTextAlignment alignment;
+  void (*draw)(GContext *ctx, GRect frame);
+} RegionLayout;
+
+static void battery_draw(GContext *ctx, GRect frame);
+static void digits_draw(GContext *ctx, GRect frame);
+
+// Rozložení ciferníku, oblasti bez fontu jsou bitmapy nebo se kreslí funkcí draw
+static const RegionLayout LAYOUT[REGION_COUNT] = {
+  [REGION_DIGITS] = { {{0, 0}, {144, 50}}, FONT_KEY_BITHAM_42_BOLD, GTextAlignmentCenter, digits_draw },
+  [REGION_SECONDS] = { {{0, 40}, {144, 25}}, FONT_KEY_GOTHIC_24_BOLD, GTextAlignmentCenter },
+  [REGION_DAY_IN_WEEK] = { {{0, 68}, {144, 50}}, FONT_KEY_GOTHIC_18_BOLD, GTextAlignmentCenter },
+  [REGION_DATE] = { {{0, 88}, {144, 50}}, FONT_KEY_GOTHIC_18, GTextAlignmentLeft },
+  [REGION_NAMEDAY1] = { {{0, 110}, {144, 50}}, FONT_KEY_GOTHIC_24, GTextAlignmentCenter },
+  [REGION_NAMEDAY2] = { {{0, 140}, {144, 50}}, FONT_KEY_GOTHIC_18, GTextAlignmentCenter },
+  [REGION_ICON] = { {{0, 46}, {20, 20}}, NULL, GTextAlignmentCenter },
+  [REGION_TEMPERATURE] = { {{22, 48}, {50, 20}}, FONT_KEY_GOTHIC_14, GTextAlignmentLeft },
+  [REGION_ICON_NEXT] = { {{124, 46}, {20, 20}}, NULL, GTextAlignmentCenter },
+  [REGION_TEMPERATURE_NEXT] = { {{94, 48}, {26, 20}}, FONT_KEY_GOTHIC_14, GTextAlignmentRight },
+  [REGION_NOW] = { {{0, 64}, {45, 20}}, FONT_KEY_GOTHIC_14, GTextAlignmentCenter },
+  [REGION_TOMORROW] = { {{99, 64}, {45, 20}}, FONT_KEY_GOTHIC_14, GTextAlignmentCenter },
+  [REGION_BATTERY] = { {{106, 91}, {9, 16}}, NULL, GTextAlignmentCenter, battery_draw },
+  [REGION_BATTERY_PERCENT] = { {{115, 91}, {30, 16}}, FONT_KEY_GOTHIC_14, GTextAlignmentRight }
+};
+
+// Aktuální obsah oblastí
+static struct {
+  const char *text[REGION_COUNT];
+  GFont font[REGION_COUNT];
+  GBitmap *bitmap[REGION_COUNT];
+  uint32_t hidden;
+} canvas;
+
+// Naposledy vykreslený obsah prvků, vrstvy se mění jen při změně obsahu
+static struct {
+  char digits[6];
+  char seconds[3];
+  char temperature[8];
+  char temperature_next[8];
+  Icon icon;
+  Icon icon_next;
+  char battery_percent[5];
+  int8_t battery_fill;
+  int8_t battery_charging;
+} view;
+
+// Denní kalendář, přepočítá se jen při změně data, jinak se kreslí z paměti
+static struct {
+  int year;
+  int yday;
+  char day_in_week[16];
+  char date[32];
+  // název svátku bez '\0', ", " a jméno
+  char nameday[2][LOCALE_HOLIDAY_SIZE - 1 + 2 + LOCALE_NAMEDAY_SIZE];
+  bool holiday[2];
+  char label[LABEL_COUNT][12];
+} calendar;
+
+// Index jazykové sady z nastavení
+static int locale;
+
+// Výchozí doba zobrazení sekund po otočení zápěstím
+#define SECONDS_WINDOW_DEFAULT 30
+
+// Úsporný režim sekund
+static AppTimer *seconds_timer = NULL;
+static bool seconds_visible = false;
+static int32_t seconds_window = SECONDS_WINDOW_DEFAULT;
+static time_t minute_mode_since = 0;
+static int32_t minute_mode_ticks = 0;
+static int32_t ticks_saved = 0;
 
 enum {
-  WEATHER_ICON_KEY,
-  WEATHER_TEMPERATURE_KEY,
-  WEATHER_ICON_NEXT_KEY,
-  WEATHER_TEMPERATURE_NEXT_KEY
+  WEATHER_DATA_KEY,
+  SECONDS_WINDOW_KEY,
+  WEATHER_INTERVAL_KEY,
+  LOW_BATTERY_KEY,
+  WEATHER_PUSH_KEY,
+  STATS_KEY,
+  LOCALE_KEY,
+  WORKER_KEY,
+  WEATHER_UNCHANGED_KEY
 };
 
-static const uint32_t WEATHER_ICONS[] = {
-  RESOURCE_ID_IMAGE_CLEAR_DAY,
-  RESOURCE_ID_IMAGE_CLEAR_NIGHT,
-  RESOURCE_ID_IMAGE_CLOUDY,
-  RESOURCE_ID_IMAGE_FOG,
-  RESOURCE_ID_IMAGE_PARTLY_CLOUDY_DAY,
-  RESOURCE_ID_IMAGE_PARTLY_CLOUDY_NIGHT,
-  RESOURCE_ID_IMAGE_RAIN,
-  RESOURCE_ID_IMAGE_SLEET,
-  RESOURCE_ID_IMAGE_SNOW,
-  RESOURCE_ID_IMAGE_WIND
-};
+// Počasí z telefonu jako jedno pole bajtů, při změně formátu zvýšit verzi
+#define WEATHER_DATA_VERSION 2
+// Teplota, kterou se nepodařilo zjistit
+#define WEATHER_UNKNOWN INT8_MIN
+// Nejvýše tolik hodinových předpovědí v jedné zprávě
+#define FORECAST_HOURS 12
+// Při méně zbývajících hodinách nebo starší předpovědi se žádá nová
+#define FORECAST_LOW 3
+#define FORECAST_STALE (3 * SECONDS_PER_HOUR)
+
+typedef struct __attribute__((packed)) {
+  int8_t temperature;
+  uint8_t icon;
+} Forecast;
+
+typedef struct __attribute__((packed)) {
+  uint8_t version;
+  int8_t temperature_next;
+  uint8_t icon_next;
+  // začátek první hodiny v bufferu
+  uint32_t start;
+  uint8_t count;
+  Forecast hours[FORECAST_HOURS];
+} WeatherData;
+
+// Poslední přijaté počasí, uložené pro okamžité zobrazení po spuštění
+typedef struct __attribute__((packed)) {
+  WeatherData weather;
+  uint32_t received;
+} WeatherSnapshot;
+
+static WeatherSnapshot weather_snapshot;
+static WeatherPolicy weather_policy;
+// Formát času se načte při otevření okna, jeho změna v nastavení ciferník stejně restartuje
+static bool clock_24h;
+// Zobrazovaná hodina ("nyní") v bufferu, posouvá se na hodinkách bez komunikace
+static uint8_t forecast_hour;
 
-static const uint32_t BATTERY_ICON[] = {
-  RESOURCE_ID_IMAGE_BATTERY_00,
-  RESOURCE_ID_IMAGE_BATTERY_10,
-  RESOURCE_ID_IMAGE_BATTERY_20,
-  RESOURCE_ID_IMAGE_BATTERY_30,
-  RESOURCE_ID_IMAGE_BATTERY_40,
-  RESOURCE_ID_IMAGE_BATTERY_50,
-  RESOURCE_ID_IMAGE_BATTERY_60,
-  RESOURCE_ID_IMAGE_BATTERY_70,
-  RESOURCE_ID_IMAGE_BATTERY_80,
-  RESOURCE_ID_IMAGE_BATTERY_90,
-  RESOURCE_ID_IMAGE_BATTERY_100
+enum {
+  PERSIST_SECONDS_WINDOW,
+  PERSIST_TICKS_SAVED,
+  PERSIST_WEATHER,
+  PERSIST_WEATHER_POLICY,
+  PERSIST_LOCALE,
+  PERSIST_WORKER,
+  PERSIST_WORKER_LAUNCHED,
+  // počítadla zabírají PERSIST_STATS .. PERSIST_STATS + STAT_COUNT, další klíče patří před ně
+  PERSIST_STATS = 100
 };
 
-static const uint32_t BATTERY_CH_ICON[] = {
-  RESOURCE_ID_IMAGE_BATTERY_CH_00,
-  RESOURCE_ID_IMAGE_BATTERY_CH_10,
-  RESOURCE_ID_IMAGE_BATTERY_CH_20,
-  RESOURCE_ID_IMAGE_BATTERY_CH_30,
-  RESOURCE_ID_IMAGE_BATTERY_CH_40,
-  RESOURCE_ID_IMAGE_BATTERY_CH_50,
-  RESOURCE_ID_IMAGE_BATTERY_CH_60,
-  RESOURCE_ID_IMAGE_BATTERY_CH_70,
-  RESOURCE_ID_IMAGE_BATTERY_CH_80,
-  RESOURCE_ID_IMAGE_BATTERY_CH_90,
-  RESOURCE_ID_IMAGE_BATTERY_CH_100
+static void seconds_mode_start(void);
+static void update_day(struct tm *t);
+
+static const Icon WEATHER_ICONS[] = {
+  ICON_CLEAR_DAY,
+  ICON_CLEAR_NIGHT,
+  ICON_CLOUDY,
+  ICON_FOG,
+  ICON_PARTLY_CLOUDY_DAY,
+  ICON_PARTLY_CLOUDY_NIGHT,
+  ICON_RAIN,
+  ICON_SLEET,
+  ICON_SNOW,
+  ICON_WIND
 };
 
-static void in_received_handler(DictionaryIterator *received, void *context) {
-	Tuple *t = dict_read_first(received);
-  // For all items
-  while(t != NULL) {
-    // Which key was received?
-    switch(t->key) {
-    	case WEATHER_TEMPERATURE_KEY:
-    		text_layer_set_text(temperature_layer, t->value->cstring);
-      	break;
-    	case WEATHER_TEMPERATURE_NEXT_KEY:
-    		text_layer_set_text(temperature_next_layer, t->value->cstring);
-    		break;
-    	case WEATHER_ICON_KEY:
-    		if (icon_bitmap) {
-		    	gbitmap_destroy(icon_bitmap);
-		    }
-		    icon_bitmap = gbitmap_create_with_resource(WEATHER_ICONS[t->value->uint8]);
-		    bitmap_layer_set_bitmap(icon_layer, icon_bitmap);
-		    break;
-    	case WEATHER_ICON_NEXT_KEY:
-    		if (icon_bitmap_next) {
-		      gbitmap_destroy(icon_bitmap_next);
-		    }
-		    icon_bitmap_next = gbitmap_create_with_resource(WEATHER_ICONS[t->value->uint8]);
-		    bitmap_layer_set_bitmap(icon_next_layer, icon_bitmap_next);
-      	break;
+// Firmware překresluje celou vrstvu, oblast jen určuje, zda je překreslení potřeba
+static void canvas_invalidate(Region region) {
+  if (!(canvas.hidden & (1 << region))) {
+    layer_mark_dirty(canvas_layer);
+  }
+}
+
+static void canvas_set_hidden(Region region, bool hidden) {
+  if (hidden) {
+    canvas.hidden |= 1 << region;
+    layer_mark_dirty(canvas_layer);
+  } else {
+    canvas.hidden &= ~(1 << region);
+    canvas_invalidate(region);
+  }
+}
+
+// Číslice 0-9 a ':' vykreslené jednou do 1bitových bitmap, čas se pak skládá jejich kopírováním
+#define GLYPH_COUNT 11
+#define GLYPH_COLON 10
+
+static struct {
+  GBitmap *bitmap[GLYPH_COUNT];
+  int16_t width[GLYPH_COUNT];
+  bool built;
+  bool ready;
+} glyphs;
+
+// Index znaku v cache, -1 pro znak, který v ní není
+static int glyph_index(char c) {
+  if (c == ':') {
+    return GLYPH_COLON;
+  }
+  return c >= '0' && c <= '9' ? c - '0' : -1;
+}
+
+#if !defined(PBL_ROUND)
+// Bod framebufferu, v 8bitovém formátu GColor8 nesou barvu dolní bity
+static bool frame_buffer_pixel(GBitmap *frame_buffer, int x, int y) {
+  uint8_t *row = gbitmap_get_data(frame_buffer) + y * gbitmap_get_bytes_per_row(frame_buffer);
+  if (gbitmap_get_format(frame_buffer) == GBitmapFormat1Bit) {
+    return row[x / 8] & (1 << (x % 8));
+  }
+  return row[x] & 0x3f;
+}
+
+// Zkopíruje právě vykreslenou oblast framebufferu do prázdné 1bitové bitmapy velikosti oblasti
+static bool frame_buffer_copy(GContext *ctx, GRect source, GBitmap *target) {
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (!frame_buffer) {
+    return false;
+  }
+  uint8_t *data = gbitmap_get_data(target);
+  uint16_t bytes_per_row = gbitmap_get_bytes_per_row(target);
+  memset(data, 0, bytes_per_row * source.size.h);
+  for (int y = 0; y < source.size.h; y++) {
+    for (int x = 0; x < source.size.w; x++) {
+      if (frame_buffer_pixel(frame_buffer, source.origin.x + x, source.origin.y + y)) {
+        data[y * bytes_per_row + x / 8] |= 1 << (x % 8);
+      }
     }
-    // Look for next item
-    t = dict_read_next(received);
   }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+  return true;
+}
+#endif
+
+// Vykreslí znaky do levého horního rohu oblasti číslic a zkopíruje je z framebufferu,
+// na kulatém displeji řádky nezačínají na x = 0, tam se zůstává u kreslení textu
+static void glyphs_build(GContext *ctx, GRect frame) {
+  glyphs.built = true;
+#if !defined(PBL_ROUND)
+  static const char *GLYPH_TEXT[GLYPH_COUNT] = {"0", "1", "2", "3", "4", "5", "6", "7", "8", "9", ":"};
+  GFont font = canvas.font[REGION_DIGITS];
+  int height = frame.size.h;
+
+  for (int i = 0; i < GLYPH_COUNT; i++) {
+    GRect box = GRect(frame.origin.x, frame.origin.y, frame.size.w, height);
+    int width = graphics_text_layout_get_content_size(GLYPH_TEXT[i], font, box, GTextOverflowModeWordWrap,
+        GTextAlignmentLeft).w;
+    GBitmap *glyph = width > 0 ? gbitmap_create_blank(GSize(width, height), GBitmapFormat1Bit) : NULL;
+    if (!glyph) {
+      break;
+    }
+    graphics_context_set_fill_color(ctx, GColorBlack);
+    graphics_fill_rect(ctx, box, 0, GCornerNone);
+    graphics_draw_text(ctx, GLYPH_TEXT[i], font, box, GTextOverflowModeWordWrap, GTextAlignmentLeft, NULL);
+    if (!frame_buffer_copy(ctx, GRect(box.origin.x, box.origin.y, width, height), glyph)) {
+      gbitmap_destroy(glyph);
+      break;
+    }
+    glyphs.bitmap[i] = glyph;
+    glyphs.width[i] = width;
+  }
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  graphics_fill_rect(ctx, frame, 0, GCornerNone);
+  glyphs.ready = glyphs.bitmap[GLYPH_COUNT - 1] != NULL;
+#endif
 }
 
-static void request_weather(void) {
-  Tuplet weather_current = TupletInteger(WEATHER_TEMPERATURE_KEY, 1);
-  Tuplet weather_next = TupletInteger(WEATHER_TEMPERATURE_NEXT_KEY, 1);
+static void glyphs_destroy(void) {
+  for (int i = 0; i < GLYPH_COUNT; i++) {
+    if (glyphs.bitmap[i]) {
+      gbitmap_destroy(glyphs.bitmap[i]);
+    }
+  }
+  memset(&glyphs, 0, sizeof(glyphs));
+}
+
+// Čas vystředěný z uložených znaků, bez nich jako text
+static void digits_draw(GContext *ctx, GRect frame) {
+  const char *text = view.digits;
+  if (!glyphs.ready) {
+    graphics_draw_text(ctx, text, canvas.font[REGION_DIGITS], frame, GTextOverflowModeWordWrap,
+        LAYOUT[REGION_DIGITS].alignment, NULL);
+    return;
+  }
+  int width = 0;
+  for (const char *c = text; *c; c++) {
+    if (glyph_index(*c) >= 0) {
+      width += glyphs.width[glyph_index(*c)];
+    }
+  }
+  int x = frame.origin.x + (frame.size.w - width) / 2;
+  for (const char *c = text; *c; c++) {
+    int glyph = glyph_index(*c);
+    if (glyph < 0) {
+      continue;
+    }
+    graphics_draw_bitmap_in_rect(ctx, glyphs.bitmap[glyph], GRect(x, frame.origin.y, glyphs.width[glyph],
+        frame.size.h));
+    x += glyphs.width[glyph];
+  }
+}
+
+static void canvas_draw_region(GContext *ctx, Region i) {
+  if (LAYOUT[i].draw) {
+    LAYOUT[i].draw(ctx, LAYOUT[i].frame);
+  } else if (canvas.bitmap[i]) {
+    graphics_draw_bitmap_in_rect(ctx, canvas.bitmap[i], LAYOUT[i].frame);
+  } else if (canvas.text[i]) {
+    graphics_draw_text(ctx, canvas.text[i], canvas.font[i], LAYOUT[i].frame, GTextOverflowModeWordWrap,
+        LAYOUT[i].alignment, NULL);
+  }
+}
 
-  DictionaryIterator *iter;
-  app_message_outbox_begin(&iter);
+// Dolní část s datem, jmeninami a popisky se mění nejvýše jednou denně, kreslí se z jedné bitmapy
+#define DAY_REGIONS ((1 << REGION_DAY_IN_WEEK) | (1 << REGION_DATE) | (1 << REGION_NAMEDAY1) | \
+    (1 << REGION_NAMEDAY2) | (1 << REGION_NOW) | (1 << REGION_TOMORROW))
+#define DAY_FRAME GRect(0, 64, 144, 104)
+
+static struct {
+  GBitmap *bitmap;
+  bool valid;
+} day_composite;
+
+// Po změně dne nebo jazyka oblasti vykreslí a uloží, jinak jen zkopíruje bitmapu,
+// vrací false, pokud se oblasti musí kreslit samostatně
+static bool day_composite_draw(GContext *ctx) {
+#if defined(PBL_ROUND)
+  return false;
+#else
+  if (!day_composite.valid) {
+    if (!day_composite.bitmap) {
+      day_composite.bitmap = gbitmap_create_blank(DAY_FRAME.size, GBitmapFormat1Bit);
+      if (!day_composite.bitmap) {
+        return false;
+      }
+    }
+    graphics_context_set_fill_color(ctx, GColorBlack);
+    graphics_fill_rect(ctx, DAY_FRAME, 0, GCornerNone);
+    for (int i = 0; i < REGION_COUNT; i++) {
+      if ((DAY_REGIONS & (1 << i)) && !(canvas.hidden & (1 << i))) {
+        canvas_draw_region(ctx, i);
+      }
+    }
+    if (!frame_buffer_copy(ctx, DAY_FRAME, day_composite.bitmap)) {
+      return false;
+    }
+    day_composite.valid = true;
+  }
+  graphics_draw_bitmap_in_rect(ctx, day_composite.bitmap, DAY_FRAME);
+  return true;
+#endif
+}
+
+static void day_composite_destroy(void) {
+  if (day_composite.bitmap) {
+    gbitmap_destroy(day_composite.bitmap);
+  }
+  memset(&day_composite, 0, sizeof(day_composite));
+}
+
+static void canvas_update_proc(Layer *layer, GContext *ctx) {
+  energy_stats_count(STAT_REDRAWS);
+  graphics_context_set_text_color(ctx, GColorWhite);
+  // znaky číslic se vykreslí jen při prvním překreslení okna
+  if (!glyphs.built) {
+    glyphs_build(ctx, LAYOUT[REGION_DIGITS].frame);
+  }
+  // denní bitmapa jako první, ostatní oblasti se kreslí přes ni
+  uint32_t skip = canvas.hidden;
+  if (day_composite_draw(ctx)) {
+    skip |= DAY_REGIONS;
+  }
+  for (int i = 0; i < REGION_COUNT; i++) {
+    if (!(skip & (1 << i))) {
+      canvas_draw_region(ctx, i);
+    }
+  }
+}
 
-  if (iter == NULL) {
+// Text se kopíruje do bufferu view modelu, oblast se překreslí jen při změně
+static void view_set_text(Region region, char *shown, size_t size, const char *text) {
+  if (strncmp(shown, text, size) == 0) {
     return;
   }
+  strncpy(shown, text, size - 1);
+  shown[size - 1] = '\0';
+  canvas.text[region] = shown;
+  canvas_invalidate(region);
+}
 
-  dict_write_tuplet(iter, &weather_current);
-  dict_write_tuplet(iter, &weather_next);
-  dict_write_end(iter);
+// Výřez z atlasu se vytvoří při prvním použití, změna ikony jen posune jeho hranice
+static void view_set_bitmap(Region region, Icon *shown, Icon icon) {
+  if (*shown == icon) {
+    return;
+  }
+  *shown = icon;
+  if (canvas.bitmap[region]) {
+    gbitmap_set_bounds(canvas.bitmap[region], ICON_ATLAS[icon]);
+  } else {
+    canvas.bitmap[region] = gbitmap_create_as_sub_bitmap(icon_atlas, ICON_ATLAS[icon]);
+    energy_stats_count(STAT_BITMAP_LOADS);
+  }
+  canvas_invalidate(region);
+}
 
-  app_message_outbox_send();
+static void temperature_text(char *buffer, size_t size, int8_t temperature) {
+  if (temperature == WEATHER_UNKNOWN) {
+    snprintf(buffer, size, "N/A");
+  } else {
+    snprintf(buffer, size, "%d°C", temperature);
+  }
 }
 
-static void configureLayer(TextLayer *textlayer, const char *font, int alignment) {
-  text_layer_set_font(textlayer, fonts_get_system_font(font));
-  text_layer_set_text_color(textlayer, GColorWhite);
-  text_layer_set_background_color(textlayer, GColorClear);
-  text_layer_set_text_alignment(textlayer, alignment);
+static const Forecast *forecast_now(void) {
+  return &weather_snapshot.weather.hours[forecast_hour];
 }
 
-static void update_day() {
+static void weather_show(void) {
+  const WeatherData *weather = &weather_snapshot.weather;
+  const Forecast *now = forecast_now();
+  char temperature[sizeof(view.temperature)];
+  temperature_text(temperature, sizeof(temperature), now->temperature);
+  view_set_text(REGION_TEMPERATURE, view.temperature, sizeof(view.temperature), temperature);
+  temperature_text(temperature, sizeof(temperature), weather->temperature_next);
+  view_set_text(REGION_TEMPERATURE_NEXT, view.temperature_next, sizeof(view.temperature_next), temperature);
+
+  if (now->icon < ARRAY_LENGTH(WEATHER_ICONS)) {
+    view_set_bitmap(REGION_ICON, &view.icon, WEATHER_ICONS[now->icon]);
+  }
+  if (weather->icon_next < ARRAY_LENGTH(WEATHER_ICONS)) {
+    view_set_bitmap(REGION_ICON_NEXT, &view.icon_next, WEATHER_ICONS[weather->icon_next]);
+  }
+}
+
+// Posune "nyní" na aktuální hodinu, po poslední hodině v bufferu zůstane u ní
+static void forecast_advance(void) {
+  const WeatherData *weather = &weather_snapshot.weather;
+  if (weather_snapshot.received == 0) {
+    return;
+  }
   time_t now = time(NULL);
-  struct tm *t = localtime(&now);
-  int day = t->tm_mday;
-  int month_no = t->tm_mon;
-  int year = t->tm_year+1900;
+  uint8_t hour = 0;
+  if (now > (time_t)weather->start) {
+    uint32_t elapsed = (now - weather->start) / SECONDS_PER_HOUR;
+    hour = elapsed < weather->count ? elapsed : (uint32_t)weather->count - 1;
+  }
+  if (hour != forecast_hour) {
+    forecast_hour = hour;
+    weather_show();
+  }
+}
 
-  char *day_of_week[7] = {"neděle", "pondělí", "úterý", "středa", "čtvrtek", "pátek", "sobota"};
-  char *month[12] = {"ledna", "února", "března", "dubna", "května", "června", "července", "srpna", "září", "října",
-      "listopadu", "prosince"};
+// Za kolik sekund v bufferu zbude méně než FORECAST_LOW hodin nebo předpověď zastará, 0 = hned
+static uint32_t weather_due(void) {
+  const WeatherData *weather = &weather_snapshot.weather;
+  if (weather_snapshot.received == 0 || weather->count <= FORECAST_LOW) {
+    return 0;
+  }
+  time_t low = weather->start + (weather->count - FORECAST_LOW) * SECONDS_PER_HOUR;
+  time_t stale = weather_snapshot.received + FORECAST_STALE;
+  time_t due = low < stale ? low : stale;
+  time_t now = time(NULL);
+  return due > now ? due - now : 0;
+}
 
-  configureLayer(day_in_week, FONT_KEY_GOTHIC_18_BOLD, GTextAlignmentCenter);
-  configureLayer(date, FONT_KEY_GOTHIC_18, GTextAlignmentLeft);
-  configureLayer(nameday1_line, public_holiday(t, 0) ? FONT_KEY_GOTHIC_24_BOLD : FONT_KEY_GOTHIC_24, GTextAlignmentCenter);
-  configureLayer(nameday2_line, public_holiday(t, 1) ? FONT_KEY_GOTHIC_18_BOLD : FONT_KEY_GOTHIC_18, GTextAlignmentCenter);
+// Snímek od workeru na pozadí, načte se při spuštění
+static WorkerSnapshot worker_snapshot;
+
+// Bez výslovného zapnutí v nastavení se worker spouští jen jednou, protože hodinky se při
+// spuštění ptají, zda nahradit worker jiné aplikace, a odmítnutí se má respektovat
+static void worker_launch(void) {
+  AppWorkerResult result = app_worker_launch();
+  persist_write_bool(PERSIST_WORKER_LAUNCHED, true);
+  if (result != APP_WORKER_RESULT_SUCCESS && result != APP_WORKER_RESULT_ALREADY_RUNNING &&
+      result != APP_WORKER_RESULT_ASKING_CONFIRMATION) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Worker nespusten: %d", (int)result);
+  }
+}
 
-  int date_size = sizeof(day) + 2 + strlen(month[month_no]) + 1 + sizeof(year);
-  char *complete_date = malloc(date_size);
-  snprintf(complete_date, date_size, "%i. %s %i", day, month[month_no], year);
-  
-  text_layer_set_text(day_in_week, day_of_week[t->tm_wday]);
-  text_layer_set_text(date, complete_date);
-  text_layer_set_text(nameday1_line, get_nameday(t, 0));
-  text_layer_set_text(nameday2_line, get_nameday(t, 1));
+static void worker_set_enabled(bool enabled) {
+  persist_write_bool(PERSIST_WORKER, enabled);
+  if (!enabled) {
+    app_worker_kill();
+  } else if (!app_worker_is_running()) {
+    worker_launch();
+  }
+}
 
+static void worker_init(void) {
+  bool enabled = persist_exists(PERSIST_WORKER) ? persist_read_bool(PERSIST_WORKER) : true;
+  if (enabled && !persist_read_bool(PERSIST_WORKER_LAUNCHED) && !app_worker_is_running()) {
+    worker_launch();
+  }
+  if (persist_read_data(WORKER_SNAPSHOT_KEY, &worker_snapshot, sizeof(worker_snapshot)) != sizeof(worker_snapshot) ||
+      worker_snapshot.version != WORKER_SNAPSHOT_VERSION) {
+    memset(&worker_snapshot, 0, sizeof(worker_snapshot));
+  }
 }
 
-static void battery_handler(BatteryChargeState new_state) {
-  static char s_battery_buffer[32];
-  snprintf(s_battery_buffer, sizeof(s_battery_buffer), "%d%%", new_state.charge_percent);
-  if (icon_battery) {
-    gbitmap_destroy(icon_battery);
+// Při rychlém přepínání aplikací platí plán z minulého běhu, žádost se hned neopakuje
+static uint32_t weather_first_delay(void) {
+  uint32_t delay = weather_due();
+  time_t now = time(NULL);
+  time_t planned = worker_snapshot.weather_due;
+  if (weather_snapshot.received && planned > now && planned - now <= FORECAST_STALE && (uint32_t)(planned - now) > delay) {
+    delay = planned - now;
+  }
+  return delay;
+}
+
+// Předá workeru plán počasí, aby ho příští spuštění převzalo
+static void worker_send_weather_due(void) {
+  if (!app_worker_is_running()) {
+    return;
   }
-  if (new_state.is_charging) {
-    icon_battery = gbitmap_create_with_resource(BATTERY_CH_ICON[new_state.charge_percent/10]);
+  uint32_t due = weather_schedule_next();
+  AppWorkerMessage message = { .data0 = due & 0xffff, .data1 = due >> 16 };
+  app_worker_send_message(WORKER_MESSAGE_WEATHER_DUE, &message);
+}
+
+// Velikost změny počasí pro plánovač: rozdíl teplot ve °C, změna ikony za 3
+static int weather_change(const Forecast *previous, const Forecast *forecast) {
+  if (previous->temperature == WEATHER_UNKNOWN || forecast->temperature == WEATHER_UNKNOWN) {
+    return INT8_MAX;
+  }
+  int change = abs(forecast->temperature - previous->temperature);
+  if (forecast->icon != previous->icon) {
+    change += 3;
+  }
+  return change;
+}
+
+static void weather_apply(const uint8_t *data, uint16_t length) {
+  const WeatherData *weather = (const WeatherData *)data;
+  if (length < offsetof(WeatherData, hours) || weather->version != WEATHER_DATA_VERSION ||
+      weather->count == 0 || weather->count > FORECAST_HOURS ||
+      length < offsetof(WeatherData, hours) + weather->count * sizeof(Forecast)) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Neznamy format pocasi");
+    return;
+  }
+  Forecast previous = weather_snapshot.received ? *forecast_now() : (Forecast) { WEATHER_UNKNOWN, 0 };
+  memset(&weather_snapshot.weather, 0, sizeof(WeatherData));
+  memcpy(&weather_snapshot.weather, data, offsetof(WeatherData, hours) + weather->count * sizeof(Forecast));
+  weather_snapshot.received = time(NULL);
+  persist_write_data(PERSIST_WEATHER, &weather_snapshot, sizeof(weather_snapshot));
+  forecast_hour = UINT8_MAX;
+  forecast_advance();
+  weather_schedule_reading(weather_change(&previous, forecast_now()), weather_due());
+}
+
+// Telefon má stejná data, jaká hodinky už zobrazují: obnoví se jen čas příjmu
+static void weather_confirm(void) {
+  if (weather_snapshot.received == 0) {
+    return;
+  }
+  weather_snapshot.received = time(NULL);
+  persist_write_data(PERSIST_WEATHER, &weather_snapshot, sizeof(weather_snapshot));
+  weather_schedule_reading(0, weather_due());
+}
+
+// Zobrazí uložené počasí posunuté na aktuální hodinu
+static void weather_restore(void) {
+  if (persist_read_data(PERSIST_WEATHER, &weather_snapshot, sizeof(weather_snapshot)) != sizeof(weather_snapshot) ||
+      weather_snapshot.weather.version != WEATHER_DATA_VERSION || weather_snapshot.weather.count == 0 ||
+      weather_snapshot.weather.count > FORECAST_HOURS) {
+    memset(&weather_snapshot, 0, sizeof(weather_snapshot));
+    return;
+  }
+  forecast_hour = UINT8_MAX;
+  forecast_advance();
+}
+
+// Počítadla pro telefon na jeho žádost
+// Za počítadly jde historie baterie od workeru, bez běžícího workeru jen s neznámými hodnotami
+#define STATS_PARTS (STAT_COUNT + 1)
+
+static void battery_history_write(DictionaryIterator *iter) {
+  // worker snímek mezitím přepisuje, čte se vždy znovu
+  WorkerSnapshot snapshot;
+  if (persist_read_data(WORKER_SNAPSHOT_KEY, &snapshot, sizeof(snapshot)) != sizeof(snapshot) ||
+      snapshot.version != WORKER_SNAPSHOT_VERSION) {
+    memset(&snapshot, 0, sizeof(snapshot));
+    memset(snapshot.battery_samples, WORKER_BATTERY_UNKNOWN, sizeof(snapshot.battery_samples));
+  }
+  uint16_t values[WORKER_BATTERY_SAMPLES];
+  for (int h = 0; h < WORKER_BATTERY_SAMPLES; h++) {
+    uint8_t sample = snapshot.battery_samples[h];
+    values[h] = sample == WORKER_BATTERY_UNKNOWN ? UINT16_MAX : sample;
+  }
+  energy_stats_write_values(iter, STATS_KEY, STAT_COUNT, STATS_PARTS, snapshot.battery_hour, values);
+}
+
+static bool stats_write(DictionaryIterator *iter, uint8_t part) {
+  if (part < STAT_COUNT) {
+    energy_stats_write(iter, STATS_KEY, part, STATS_PARTS);
   } else {
-    icon_battery = gbitmap_create_with_resource(BATTERY_ICON[new_state.charge_percent/10]);
+    battery_history_write(iter);
   }
-  bitmap_layer_set_bitmap(battery_layer, icon_battery);
-  text_layer_set_text(battery_percent_layer, s_battery_buffer);
+  return part + 1 < STATS_PARTS;
 }
 
-static void update_time() {
-  time_t now = time(NULL);
-  struct tm *t = localtime(&now);
+static void in_received_handler(DictionaryIterator *received, void *context) {
+  PROBE_BEGIN();
+  energy_stats_count(STAT_MESSAGES_RECEIVED);
+  // nastavení chodí pohromadě, plánovač se přeplánuje jednou za zprávu
+  bool policy_changed = false;
+	Tuple *t = dict_read_first(received);
+  // For all items
+  while(t != NULL) {
+    // Which key was received?
+    switch(t->key) {
+    	case WEATHER_DATA_KEY:
+    		weather_apply(t->value->data, t->length);
+      	break;
+      case WEATHER_UNCHANGED_KEY:
+        weather_confirm();
+        break;
+      case SECONDS_WINDOW_KEY:
+        seconds_window = t->value->int32;
+        persist_write_int(PERSIST_SECONDS_WINDOW, seconds_window);
+        seconds_mode_start();
+        break;
+      case WEATHER_INTERVAL_KEY:
+        weather_policy.interval = t->value->int32 > 0 ? t->value->int32 : WEATHER_POLICY_DEFAULT.interval;
+        policy_changed = true;
+        break;
+      case LOW_BATTERY_KEY:
+        weather_policy.low_battery = t->value->int32;
+        policy_changed = true;
+        break;
+      case LOCALE_KEY: {
+        locale = t->value->int32;
+        persist_write_int(PERSIST_LOCALE, locale);
+        locale_load(locale);
+        time_t now = time(NULL);
+        update_day(localtime(&now));
+        break;
+      }
+      case STATS_KEY:
+        message_queue_send(stats_write);
+        break;
+      case WEATHER_PUSH_KEY:
+        weather_policy.push = t->value->int32 != 0;
+        policy_changed = true;
+        break;
+      case WORKER_KEY:
+        worker_set_enabled(t->value->int32 != 0);
+        break;
+    }
+    // Look for next item
+    t = dict_read_next(received);
+  }
+  if (policy_changed) {
+    persist_write_data(PERSIST_WEATHER_POLICY, &weather_policy, sizeof(weather_policy));
+    weather_schedule_set_policy(weather_policy);
+  }
+  PROBE_END(PROBE_INBOX);
+}
 
-  configureLayer(main_digits, FONT_KEY_BITHAM_42_BOLD, GTextAlignmentCenter);
-  configureLayer(seconds, FONT_KEY_GOTHIC_24_BOLD, GTextAlignmentCenter);
+// Žádost obsahuje verzi formátu, kterou ciferník očekává
+static bool weather_request_write(DictionaryIterator *iter, uint8_t part) {
+  dict_write_uint8(iter, WEATHER_DATA_KEY, WEATHER_DATA_VERSION);
+  return false;
+}
 
-  static char digits[] = "00:00";
+static void request_weather(void) {
+  energy_stats_count(STAT_WEATHER_REQUESTS);
+  message_queue_send(weather_request_write);
+}
 
-  if(clock_is_24h_style() == true) {
-    // Use 24 hour format
-    strftime(digits, sizeof("00:00"), "%H:%M", t);
+// Jméno doplněné o název pohyblivého svátku
+static void nameday_text(char *buffer, size_t size, struct tm *t, int future) {
+  char holiday[LOCALE_HOLIDAY_SIZE];
+  char nameday[LOCALE_NAMEDAY_SIZE];
+  get_nameday(t, future, nameday, sizeof(nameday));
+  if (movable_holiday(t, future, holiday, sizeof(holiday))) {
+    snprintf(buffer, size, "%s, %s", holiday, nameday);
   } else {
-    // Use 12 hour format
-    strftime(digits, sizeof("00:00"), "%I:%M", t);
+    snprintf(buffer, size, "%s", nameday);
   }
-  text_layer_set_text(main_digits, digits);
+}
 
-  static char secs[] = "00";
-  strftime(secs, sizeof("00"), "%S", t);
+static bool calendar_current(struct tm *t) {
+  return t->tm_yday == calendar.yday && t->tm_year == calendar.year;
+}
+
+static void update_day(struct tm *t) {
+  char month[16];
+
+  calendar.year = t->tm_year;
+  calendar.yday = t->tm_yday;
+  // názvy se čtou z jazykové sady jen při změně dne
+  locale_weekday(t->tm_wday, calendar.day_in_week, sizeof(calendar.day_in_week));
+  locale_month(t->tm_mon, month, sizeof(month));
+  snprintf(calendar.date, sizeof(calendar.date), "%i. %s %i", t->tm_mday, month, t->tm_year+1900);
+  for (int i = 0; i < LABEL_COUNT; i++) {
+    locale_label(i, calendar.label[i], sizeof(calendar.label[i]));
+  }
+  for (int future = 0; future < 2; future++) {
+    nameday_text(calendar.nameday[future], sizeof(calendar.nameday[future]), t, future);
+    calendar.holiday[future] = public_holiday(t, future);
+  }
+
+  canvas.text[REGION_DAY_IN_WEEK] = calendar.day_in_week;
+  canvas.text[REGION_DATE] = calendar.date;
+  canvas.text[REGION_NAMEDAY1] = calendar.nameday[0];
+  canvas.text[REGION_NAMEDAY2] = calendar.nameday[1];
+  canvas.text[REGION_NOW] = calendar.label[LABEL_NOW];
+  canvas.text[REGION_TOMORROW] = calendar.label[LABEL_TOMORROW];
+  canvas.font[REGION_NAMEDAY1] = fonts_get_system_font(calendar.holiday[0] ? FONT_KEY_GOTHIC_24_BOLD : FONT_KEY_GOTHIC_24);
+  canvas.font[REGION_NAMEDAY2] = fonts_get_system_font(calendar.holiday[1] ? FONT_KEY_GOTHIC_18_BOLD : FONT_KEY_GOTHIC_18);
+  // denní oblasti se mění vždy společně a s nimi i jejich bitmapa
+  day_composite.valid = false;
+  canvas_invalidate(REGION_DAY_IN_WEEK);
+}
 
-  text_layer_set_text(seconds, secs);
+// Ukazatel baterie 9x16: kontakt, obrys, náplň až BATTERY_FILL_MAX pixelů a blesk při nabíjení
+#define BATTERY_FILL_MAX 10
 
-  // aktualizace každý den o půlnoci
-  if (t->tm_hour == 0 && t->tm_min == 0 && t->tm_sec == 0) {
-    update_day();
+static const GPoint BATTERY_BOLT[] = {
+  {5, 7}, {4, 8}, {3, 9}, {4, 9}, {5, 9}, {4, 10}, {3, 11}
+};
+
+static void battery_draw(GContext *ctx, GRect frame) {
+  int x = frame.origin.x;
+  int y = frame.origin.y;
+  int fill = view.battery_fill;
+
+  graphics_context_set_stroke_color(ctx, GColorWhite);
+  graphics_context_set_fill_color(ctx, GColorWhite);
+  graphics_fill_rect(ctx, GRect(x + 3, y, 3, 2), 0, GCornerNone);
+  graphics_draw_rect(ctx, GRect(x, y + 2, 9, 14));
+  if (fill > 0) {
+    graphics_fill_rect(ctx, GRect(x + 2, y + 14 - fill, 5, fill), 0, GCornerNone);
+  }
+
+  if (view.battery_charging == 1) {
+    // v náplni se blesk kreslí inverzně
+    for (unsigned int i = 0; i < ARRAY_LENGTH(BATTERY_BOLT); i++) {
+      GPoint point = BATTERY_BOLT[i];
+      graphics_context_set_stroke_color(ctx, point.y >= 14 - fill ? GColorBlack : GColorWhite);
+      graphics_draw_pixel(ctx, GPoint(x + point.x, y + point.y));
+    }
   }
-  // aktualizace počasí každých 20 minut
-  if ((t->tm_min == 2 || t->tm_min == 22 || t->tm_min == 42) && t->tm_sec == 0) {
-  	request_weather();
+}
+
+static void battery_handler(BatteryChargeState new_state) {
+  PROBE_BEGIN();
+  char battery_percent[sizeof(view.battery_percent)];
+  snprintf(battery_percent, sizeof(battery_percent), "%d%%", new_state.charge_percent);
+
+  // překreslit jen při změně zobrazené výšky náplně
+  int fill = (new_state.charge_percent * BATTERY_FILL_MAX + 50) / 100;
+  if (fill != view.battery_fill || new_state.is_charging != view.battery_charging) {
+    view.battery_fill = fill;
+    view.battery_charging = new_state.is_charging;
+    canvas_invalidate(REGION_BATTERY);
   }
+  view_set_text(REGION_BATTERY_PERCENT, view.battery_percent, sizeof(view.battery_percent), battery_percent);
+  PROBE_END(PROBE_BATTERY);
+}
 
+// Dvojice číslic 00 až 59, na každý tik se jen kopírují místo strftime
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859";
+
+// Přepíše dvě číslice, vrací true, pokud se změnily
+static bool digit_pair_set(char *shown, int value) {
+  const char *pair = &DIGIT_PAIRS[value * 2];
+  if (shown[0] == pair[0] && shown[1] == pair[1]) {
+    return false;
+  }
+  shown[0] = pair[0];
+  shown[1] = pair[1];
+  return true;
+}
+
+static void update_time(struct tm *t) {
+  int hour = t->tm_hour;
+  if (!clock_24h) {
+    hour %= 12;
+    if (hour == 0) {
+      hour = 12;
+    }
+  }
+  // bitový součet, aby se vždy zapsaly obě dvojice
+  if (digit_pair_set(&view.digits[0], hour) | digit_pair_set(&view.digits[3], t->tm_min)) {
+    canvas_invalidate(REGION_DIGITS);
+  }
+
+  // skryté sekundy se nepřekreslují
+  if (seconds_visible && digit_pair_set(view.seconds, t->tm_sec)) {
+    canvas_invalidate(REGION_SECONDS);
+  }
 }
 
 static void main_window_load(Window *window) {
+  PROBE_BEGIN();
   window_set_background_color(window, GColorBlack);
 
-  // Hodiny s minutami
-  main_digits = text_layer_create(GRect(0, 0, 144, 50));
-  // Sekundy
-  seconds = text_layer_create(GRect(0, 40, 144, 25));
-
-  update_time();
-
-  // Dent v týdnu
-  day_in_week = text_layer_create(GRect(0, 68, 144, 50));
-  // Datum
-  date = text_layer_create(GRect(0, 88, 144, 50));
-  // Dnešní svátek
-  nameday1_line = text_layer_create(GRect(0, 110, 144, 50));
-  // Zítřejší svátek
-  nameday2_line = text_layer_create(GRect(0, 140, 144, 50));
-  
-  update_day();
-
-  icon_layer = bitmap_layer_create(GRect(0, 46, 20, 20));
-  temperature_layer = text_layer_create(GRect(22, 48, 50, 20));
-  configureLayer(temperature_layer, FONT_KEY_GOTHIC_14, GTextAlignmentLeft);
-
-  icon_next_layer = bitmap_layer_create(GRect(124, 46, 20, 20));
-  temperature_next_layer = text_layer_create(GRect(94, 48, 26, 20));
-  configureLayer(temperature_next_layer, FONT_KEY_GOTHIC_14, GTextAlignmentRight);
-
-  now_layer = text_layer_create(GRect(0, 64, 45, 20));
-  configureLayer(now_layer, FONT_KEY_GOTHIC_14, GTextAlignmentCenter);
-  text_layer_set_text(now_layer, "nyní");
-  tomorrow_layer = text_layer_create(GRect(99, 64, 45, 20));
-  configureLayer(tomorrow_layer, FONT_KEY_GOTHIC_14, GTextAlignmentCenter);
-  text_layer_set_text(tomorrow_layer, "zítra");
-
-  request_weather();
-
-  battery_layer = bitmap_layer_create(GRect(106, 91, 9, 16));
-  battery_percent_layer = text_layer_create(GRect(115, 91, 30, 16));
-  configureLayer(battery_percent_layer, FONT_KEY_GOTHIC_14, GTextAlignmentRight);
+  memset(&view, 0, sizeof(view));
+  view.icon = ICON_COUNT;
+  view.icon_next = ICON_COUNT;
+  view.battery_fill = -1;
+  view.battery_charging = -1;
+  memset(&calendar, 0, sizeof(calendar));
+  calendar.yday = -1;
+
+  memset(&canvas, 0, sizeof(canvas));
+  icon_atlas = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_ICON_ATLAS);
+  energy_stats_count(STAT_BITMAP_LOADS);
+  for (int i = 0; i < REGION_COUNT; i++) {
+    if (LAYOUT[i].font) {
+      canvas.font[i] = fonts_get_system_font(LAYOUT[i].font);
+    }
+  }
+  view.digits[2] = ':';
+  canvas.text[REGION_DIGITS] = view.digits;
+  canvas.text[REGION_SECONDS] = view.seconds;
+  clock_24h = clock_is_24h_style();
 
-  battery_handler(battery_state_service_peek());
+  Layer *window_layer = window_get_root_layer(window);
+  canvas_layer = layer_create(layer_get_bounds(window_layer));
+  layer_set_update_proc(canvas_layer, canvas_update_proc);
+  layer_add_child(window_layer, canvas_layer);
 
-  layer_add_child(window_get_root_layer(window), text_layer_get_layer(main_digits));
-  layer_add_child(window_get_root_layer(window), text_layer_get_layer(seconds));
-  layer_add_child(window_get_root_layer(window), text_layer_get_layer(day_in_week));
-  layer_add_child(window_get_root_layer(window), text_layer_get_layer(date));
-  layer_add_child(window_get_root_layer(window), text_layer_get_layer(nameday1_line));
-  layer_add_child(window_get_root_layer(window), text_layer_get_layer(nameday2_line));
-  layer_add_child(window_get_root_layer(window), bitmap_layer_get_layer(icon_layer));
-  layer_add_child(window_get_root_layer(window), text_layer_get_layer(temperature_layer));
-  layer_add_child(window_get_root_layer(window), bitmap_layer_get_layer(icon_next_layer));
-  layer_add_child(window_get_root_layer(window), text_layer_get_layer(temperature_next_layer));
-  layer_add_child(window_get_root_layer(window), text_layer_get_layer(now_layer));
-  layer_add_child(window_get_root_layer(window), text_layer_get_layer(tomorrow_layer));
-  layer_add_child(window_get_root_layer(window), bitmap_layer_get_layer(battery_layer));
-  layer_add_child(window_get_root_layer(window), text_layer_get_layer(battery_percent_layer));
+  time_t now = time(NULL);
+  struct tm *t = localtime(&now);
+  update_day(t);
+  update_time(t);
+  weather_restore();
+  battery_handler(battery_state_service_peek());
+  PROBE_END(PROBE_WINDOW_LOAD);
 }
 
 static void main_window_unload(Window *window) {
-  // Destroy TextLayer
-  text_layer_destroy(main_digits);
-  text_layer_destroy(seconds);
-  text_layer_destroy(day_in_week);
-  text_layer_destroy(date);
-  text_layer_destroy(nameday1_line);
-  text_layer_destroy(nameday2_line);
-  bitmap_layer_destroy(icon_layer);
-  text_layer_destroy(temperature_layer);
-  bitmap_layer_destroy(icon_next_layer);
-  text_layer_destroy(temperature_next_layer);
-  if (icon_bitmap) {
-    gbitmap_destroy(icon_bitmap);
-  }
-  if (icon_bitmap_next) {
-    gbitmap_destroy(icon_bitmap_next);
-  }
-  text_layer_destroy(now_layer);
-  text_layer_destroy(tomorrow_layer);
-  text_layer_destroy(battery_percent_layer);
-  bitmap_layer_destroy(battery_layer);
-  if (icon_battery) {
-    gbitmap_destroy(icon_battery);
+  instrument_report();
+  layer_destroy(canvas_layer);
+  for (int i = 0; i < REGION_COUNT; i++) {
+    if (canvas.bitmap[i]) {
+      gbitmap_destroy(canvas.bitmap[i]);
+      canvas.bitmap[i] = NULL;
+    }
   }
+  gbitmap_destroy(icon_atlas);
+  glyphs_destroy();
+  day_composite_destroy();
 }
 
 static void refresh_every_second(struct tm *tick_time, TimeUnits units_changed) {
+  PROBE_BEGIN();
+  energy_stats_count(STAT_TICKS);
+  if (!seconds_visible) {
+    minute_mode_ticks++;
+  }
   // Aktualizace času
-  update_time();
+  update_time(tick_time);
+  // Aktualizace kalendáře při změně dne, i když půlnoční tik nepřišel
+  if ((units_changed & DAY_UNIT) || !calendar_current(tick_time)) {
+    update_day(tick_time);
+  }
+  if (units_changed & HOUR_UNIT) {
+    forecast_advance();
+  }
+  PROBE_END(PROBE_TICK);
+}
+
+// Sečte ušetřené sekundové tiky za dobu, kdy běžel minutový režim
+static void minute_mode_account(void) {
+  if (seconds_visible || minute_mode_since == 0) {
+    return;
+  }
+  time_t now = time(NULL);
+  ticks_saved += (now - minute_mode_since) - minute_mode_ticks;
+  minute_mode_since = now;
+  minute_mode_ticks = 0;
+}
+
+static void seconds_mode_stop(void *data) {
+  seconds_timer = NULL;
+  seconds_visible = false;
+  minute_mode_since = time(NULL);
+  minute_mode_ticks = 0;
+  canvas_set_hidden(REGION_SECONDS, true);
+  tick_timer_service_subscribe(MINUTE_UNIT, refresh_every_second);
+}
+
+// Zobrazí sekundy na seconds_window sekund, 0 = trvale
+static void seconds_mode_start(void) {
+  if (!seconds_visible) {
+    minute_mode_account();
+    seconds_visible = true;
+    canvas_set_hidden(REGION_SECONDS, false);
+    tick_timer_service_subscribe(SECOND_UNIT, refresh_every_second);
+    time_t now = time(NULL);
+    update_time(localtime(&now));
+  }
+  if (seconds_timer) {
+    app_timer_cancel(seconds_timer);
+    seconds_timer = NULL;
+  }
+  if (seconds_window > 0) {
+    seconds_timer = app_timer_register(seconds_window * 1000, seconds_mode_stop, NULL);
+  }
+}
+
+static void tap_handler(AccelAxisType axis, int32_t direction) {
+  seconds_mode_start();
 }
 
 // Register any app message handlers.
 static void app_message_init(void) {
     app_message_register_inbox_received(in_received_handler);
-
-    app_message_open(128, 128);
+    message_queue_init();
+
+    // Buffery jen pro skutečné zprávy: počasí nebo nastavení dovnitř, žádost o počasí nebo jedno počítadlo ven
+    uint32_t weather_size = dict_calc_buffer_size(1, sizeof(WeatherData));
+    // velikost se udává zvlášť pro každou položku
+    uint32_t settings_size = dict_calc_buffer_size(6, sizeof(int32_t), sizeof(int32_t), sizeof(int32_t),
+        sizeof(int32_t), sizeof(int32_t), sizeof(int32_t));
+    app_message_open(weather_size > settings_size ? weather_size : settings_size,
+                     dict_calc_buffer_size(1, STATS_CHUNK_SIZE));
 }
 
 static void init() {
+  if (persist_exists(PERSIST_SECONDS_WINDOW)) {
+    seconds_window = persist_read_int(PERSIST_SECONDS_WINDOW);
+  }
+  ticks_saved = persist_read_int(PERSIST_TICKS_SAVED);
+  energy_stats_init(PERSIST_STATS);
+  locale = persist_read_int(PERSIST_LOCALE);
+  locale_load(locale);
+  weather_policy = WEATHER_POLICY_DEFAULT;
+  persist_read_data(PERSIST_WEATHER_POLICY, &weather_policy, sizeof(weather_policy));
+  // Worker na pozadí udržuje baterii a plán počasí i při zavřeném ciferníku, lze ho vypnout v nastavení
+  worker_init();
+
   // Create main Window element and assign to pointer
   s_main_window = window_create();
   app_message_init();
@@ -312,14 +970,30 @@ static void init() {
   });
 
   window_stack_push(s_main_window, true);
-  // Registrace sekundového sledování
-  tick_timer_service_subscribe(SECOND_UNIT, refresh_every_second);
+  // Obnova počasí podle plánovače, zastaralé uložené počasí se žádá hned, v režimu push vůbec
+  weather_schedule_init(weather_policy, request_weather, weather_first_delay());
+  // Registrace sekundového sledování, po uplynutí okna přejde na minutové
+  seconds_mode_start();
+  // Sekundy znovu zobrazí otočení zápěstím nebo poklepání
+  accel_tap_service_subscribe(tap_handler);
   // Registrace sledování baterie
   battery_state_service_subscribe(battery_handler);
 }
 
 static void deinit() {
+    minute_mode_account();
+    persist_write_int(PERSIST_TICKS_SAVED, ticks_saved);
+    APP_LOG(APP_LOG_LEVEL_INFO, "Usetreno sekundovych tiku: %ld", (long)ticks_saved);
+
+    if (seconds_timer) {
+      app_timer_cancel(seconds_timer);
+    }
+    accel_tap_service_unsubscribe();
     tick_timer_service_unsubscribe();
+    worker_send_weather_due();
+    weather_schedule_deinit();
+    energy_stats_deinit();
+    message_queue_deinit();
     app_message_deregister_callbacks();
     window_stack_remove(s_main_window, true);
     // Destroy Window
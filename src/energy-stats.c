@@ -0,0 +1,83 @@
+#include <pebble.h>
+#include "energy-stats.h"
+
+// Počítadlo hodiny h je v buckets[stat][h % STATS_HOURS]
+static uint16_t buckets[STAT_COUNT][STATS_HOURS];
+static uint32_t current_hour;
+static uint32_t persist_base;
+
+static uint32_t hour_now(void) {
+  return time(NULL) / SECONDS_PER_HOUR;
+}
+
+static void stats_save(void) {
+  persist_write_int(persist_base, current_hour);
+  for (int stat = 0; stat < STAT_COUNT; stat++) {
+    persist_write_data(persist_base + 1 + stat, buckets[stat], sizeof(buckets[stat]));
+  }
+}
+
+// Vynuluje hodiny, které uplynuly od posledního záznamu
+static void stats_advance(uint32_t hour) {
+  uint32_t elapsed = hour - current_hour;
+  if (hour < current_hour || elapsed >= STATS_HOURS) {
+    memset(buckets, 0, sizeof(buckets));
+  } else {
+    for (uint32_t h = current_hour + 1; h <= hour; h++) {
+      for (int stat = 0; stat < STAT_COUNT; stat++) {
+        buckets[stat][h % STATS_HOURS] = 0;
+      }
+    }
+  }
+  current_hour = hour;
+}
+
+void energy_stats_init(uint32_t persist_key) {
+  persist_base = persist_key;
+  memset(buckets, 0, sizeof(buckets));
+  current_hour = persist_read_int(persist_base);
+  for (int stat = 0; stat < STAT_COUNT; stat++) {
+    persist_read_data(persist_base + 1 + stat, buckets[stat], sizeof(buckets[stat]));
+  }
+  stats_advance(hour_now());
+}
+
+void energy_stats_deinit(void) {
+  stats_save();
+}
+
+void energy_stats_count(Stat stat) {
+  uint32_t hour = hour_now();
+  if (hour != current_hour) {
+    stats_advance(hour);
+    // uložit jednou za hodinu, ať se při pádu neztratí víc
+    stats_save();
+  }
+  uint16_t *bucket = &buckets[stat][hour % STATS_HOURS];
+  if (*bucket < UINT16_MAX) {
+    (*bucket)++;
+  }
+}
+
+void energy_stats_write_values(DictionaryIterator *iter, uint32_t key, uint8_t index, uint8_t count,
+                               uint32_t hour, const uint16_t *values) {
+  uint8_t data[STATS_CHUNK_SIZE];
+  uint8_t *out = data;
+  *out++ = STATS_DATA_VERSION;
+  *out++ = index;
+  *out++ = count;
+  for (int i = 0; i < 4; i++) {
+    *out++ = hour >> (8 * i);
+  }
+  for (uint32_t h = hour + 1; h <= hour + STATS_HOURS; h++) {
+    uint16_t value = values[h % STATS_HOURS];
+    *out++ = value & 0xff;
+    *out++ = value >> 8;
+  }
+  dict_write_data(iter, key, data, sizeof(data));
+}
+
+void energy_stats_write(DictionaryIterator *iter, uint32_t key, Stat stat, uint8_t count) {
+  stats_advance(hour_now());
+  energy_stats_write_values(iter, key, stat, count, current_hour, buckets[stat]);
+}
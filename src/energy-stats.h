@@ -0,0 +1,33 @@
+#pragma once
+#include <pebble.h>
+
+// Počítadla událostí, které budí hodinky, po hodinách za posledních 24 hodin
+typedef enum {
+  STAT_TICKS,
+  STAT_REDRAWS,
+  STAT_MESSAGES_SENT,
+  STAT_MESSAGES_RECEIVED,
+  STAT_MESSAGES_FAILED,
+  STAT_BITMAP_LOADS,
+  STAT_WEATHER_REQUESTS,
+  // žádosti o počasí vynechané ve spánku
+  STAT_WEATHER_SKIPPED,
+  STAT_COUNT
+} Stat;
+
+#define STATS_HOURS 24
+#define STATS_DATA_VERSION 2
+// Jedna řada ve zprávě pro telefon: verze, index, počet řad, hodina od epochy (uint32),
+// pak STATS_HOURS hodnot uint16 od nejstarší hodiny
+#define STATS_CHUNK_SIZE (1 + 1 + 1 + 4 + STATS_HOURS * 2)
+
+// Načte počítadla z persist klíčů persist_key .. persist_key + STAT_COUNT
+void energy_stats_init(uint32_t persist_key);
+void energy_stats_deinit(void);
+void energy_stats_count(Stat stat);
+// Zapíše počítadlo stat jako řadu číslo stat z count
+void energy_stats_write(DictionaryIterator *iter, uint32_t key, Stat stat, uint8_t count);
+// Zapíše jiné hodinové hodnoty ve stejném formátu, values[h % STATS_HOURS] patří hodině h
+// a poslední je hodina hour
+void energy_stats_write_values(DictionaryIterator *iter, uint32_t key, uint8_t index, uint8_t count,
+                               uint32_t hour, const uint16_t *values);
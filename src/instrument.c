@@ -0,0 +1,89 @@
+#include <pebble.h>
+#include "instrument.h"
+
+#if defined(INSTRUMENT)
+
+// Průběžné hodnoty se vypíší po každých PROBE_WINDOW voláních
+#define PROBE_WINDOW 60
+
+typedef struct {
+  uint32_t calls;
+  uint32_t time_total;
+  uint32_t time_max;
+  int32_t heap_delta_max;
+} ProbeStats;
+
+static const char *PROBE_NAMES[PROBE_COUNT] = {
+  [PROBE_TICK] = "tick",
+  [PROBE_INBOX] = "inbox",
+  [PROBE_BATTERY] = "battery",
+  [PROBE_WINDOW_LOAD] = "window_load"
+};
+
+// Okno pro průběžné hodnoty a celkové hodnoty za běh
+static ProbeStats window[PROBE_COUNT];
+static ProbeStats total[PROBE_COUNT];
+static size_t heap_used_max;
+static size_t heap_free_min = SIZE_MAX;
+
+static uint32_t now_ms(void) {
+  time_t seconds;
+  uint16_t ms;
+  time_ms(&seconds, &ms);
+  return (uint32_t)seconds * 1000 + ms;
+}
+
+static void stats_add(ProbeStats *stats, uint32_t time, int32_t heap_delta) {
+  stats->calls++;
+  stats->time_total += time;
+  if (time > stats->time_max) {
+    stats->time_max = time;
+  }
+  if (heap_delta > stats->heap_delta_max) {
+    stats->heap_delta_max = heap_delta;
+  }
+}
+
+static void stats_log(const char *label, Probe probe, const ProbeStats *stats) {
+  if (stats->calls == 0) {
+    return;
+  }
+  APP_LOG(APP_LOG_LEVEL_INFO, "%s %s: %lu volani, prumer %lu ms, max %lu ms, halda max +%ld B", label,
+      PROBE_NAMES[probe], (unsigned long)stats->calls, (unsigned long)(stats->time_total / stats->calls),
+      (unsigned long)stats->time_max, (long)stats->heap_delta_max);
+}
+
+ProbeMark probe_begin(void) {
+  return (ProbeMark) { .start_ms = now_ms(), .heap_used = heap_bytes_used() };
+}
+
+void probe_end(Probe probe, ProbeMark mark) {
+  uint32_t time = now_ms() - mark.start_ms;
+  size_t heap_used = heap_bytes_used();
+  size_t heap_free = heap_bytes_free();
+  int32_t heap_delta = (int32_t)heap_used - (int32_t)mark.heap_used;
+
+  if (heap_used > heap_used_max) {
+    heap_used_max = heap_used;
+  }
+  if (heap_free < heap_free_min) {
+    heap_free_min = heap_free;
+  }
+  stats_add(&window[probe], time, heap_delta);
+  stats_add(&total[probe], time, heap_delta);
+
+  if (window[probe].calls >= PROBE_WINDOW) {
+    stats_log("Okno", probe, &window[probe]);
+    memset(&window[probe], 0, sizeof(window[probe]));
+  }
+}
+
+void instrument_report(void) {
+  for (int i = 0; i < PROBE_COUNT; i++) {
+    stats_log("Celkem", i, &total[i]);
+  }
+  APP_LOG(APP_LOG_LEVEL_INFO, "Halda: nejvice obsazeno %lu B, nejmene volno %lu B", (unsigned long)heap_used_max,
+      (unsigned long)heap_free_min);
+}
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+#include <pebble.h>
+
+// Měření vstupních bodů ciferníku, zapíná se sestavením s INSTRUMENT=1
+typedef enum {
+  PROBE_TICK,
+  PROBE_INBOX,
+  PROBE_BATTERY,
+  PROBE_WINDOW_LOAD,
+  PROBE_COUNT
+} Probe;
+
+#if defined(INSTRUMENT)
+
+typedef struct {
+  uint32_t start_ms;
+  size_t heap_used;
+} ProbeMark;
+
+ProbeMark probe_begin(void);
+void probe_end(Probe probe, ProbeMark mark);
+// Souhrn za celou dobu běhu do logu
+void instrument_report(void);
+
+#define PROBE_BEGIN() ProbeMark probe_mark = probe_begin()
+#define PROBE_END(probe) probe_end(probe, probe_mark)
+
+#else
+
+#define PROBE_BEGIN()
+#define PROBE_END(probe)
+#define instrument_report()
+
+#endif
@@ -25,84 +25,544 @@ function iconFromWeatherId(weatherId, daynight) {
   }
 }
 
-var temperature = "-";
-var icon;
-var temperature_next = "-";
-var icon_next;
-
-function fetchWeather(latitude, longitude) {
-  var req = new XMLHttpRequest();
-  
-  req.open('GET', "http://api.openweathermap.org/data/2.5/weather?" +
-    "lat=" + latitude + "&lon=" + longitude + "&cnt=1", true);
-  req.onload = function(e) {
-    if (req.readyState == 4) {
-      if(req.status == 200) {
-        console.log(req.responseText);
-
-        var response = JSON.parse(req.responseText);
-        temperature = Math.round(response.main.temp - 273.15);
-        icon = iconFromWeatherId(response.weather[0].id, response.weather[0].icon.slice(-1));
-        var city = response.name;
-        console.log(city);
-        sendWeather();
-      } else {
-        console.log("Error");
-      }
+// Binární formát počasí pro hodinky, musí odpovídat WeatherData v czDigiWatch.c
+var WEATHER_DATA_VERSION = 2;
+var WEATHER_UNKNOWN = -128;
+var ICON_NONE = 255;
+// Počet hodinových předpovědí v jedné zprávě
+var FORECAST_HOURS = 12;
+// Kolik hodin musí v bufferu hodinek zbývat, jinak je třeba poslat nová data
+var FORECAST_LOW = 3;
+var HOUR = 3600;
+
+function hourStart(time) {
+  return Math.floor(time / HOUR) * HOUR;
+}
+
+// Poslední úplné počasí jako {start: začátek první hodiny (s), hours: [[teplota, ikona], ...],
+// next: [teplota, ikona]}, null dokud žádné není
+var weather = null;
+
+// Hodiny od začátku aktuální hodiny: první je současné počasí, další z tříhodinové předpovědi
+function forecastHours(current, list) {
+  var start = hourStart(Date.now() / 1000);
+  var hours = [current];
+  for (var k = 1; k < FORECAST_HOURS; k++) {
+    var time = start + k * HOUR;
+    var slot = null;
+    for (var i = 0; i < list.length && list[i].dt <= time; i++) {
+      slot = list[i];
+    }
+    if (!slot) {
+      hours.push(current);
+    } else {
+      hours.push([Math.round(slot.main.temp - 273.15), iconFromWeatherId(slot.weather[0].id, slot.weather[0].icon.slice(-1))]);
+    }
+  }
+  return {start: start, hours: hours};
+}
+
+// Jak dlouho čekat na všechny odpovědi, než se pošle to, co je k dispozici
+var FETCH_TIMEOUT = 15000;
+
+// Bez současného počasí a předpovědi se nic neposílá ani neukládá, hodinky si ponechají
+// svůj platný buffer. Chybějící zítřek se vezme z posledního úplného počasí.
+function fetchWeather(latitude, longitude, answer) {
+  var pending = 3;
+  var sent = false;
+  var timeout = setTimeout(function() {
+    console.log("Weather fetch timed out");
+    finish();
+  }, FETCH_TIMEOUT);
+
+  var current = null;
+  var list = null;
+  var next = null;
+
+  // Hodinky dostanou jedinou zprávu, až doběhnou všechny požadavky nebo vyprší čas
+  function finish() {
+    if (sent) {
+      return;
+    }
+    sent = true;
+    clearTimeout(timeout);
+    if (!current || !list) {
+      console.log("Weather incomplete, keeping the last forecast");
+      return;
+    }
+    if (!next) {
+      next = weather ? weather.next : [WEATHER_UNKNOWN, ICON_NONE];
     }
+    var forecast = forecastHours(current, list);
+    weather = {start: forecast.start, hours: forecast.hours, next: next};
+    cacheStore(latitude, longitude);
+    sendWeather(answer);
   }
-  req.send(null);
-
-  req2 = new XMLHttpRequest();
-  req2.open('GET', "http://api.openweathermap.org/data/2.5/forecast/daily?" +
-    "lat=" + latitude + "&lon=" + longitude + "&cnt=2", true);
-  req2.onload = function(e) {
-    if (req2.readyState == 4) {
-      if(req2.status == 200) {
-        console.log(req2.responseText);
-        
-        var response = JSON.parse(req2.responseText);
-        temperature_next = Math.round(response.list[1].temp.day - 273.15);
-        icon_next = iconFromWeatherId(response.list[1].weather[0].id, response.list[1].weather[0].icon.slice(-1));
-        var city = response.city.name;
-        console.log(city);
-        sendWeather();
-      } else {
-        console.log("Error");
+
+  function requestDone() {
+    pending--;
+    if (pending === 0) {
+      finish();
+    }
+  }
+
+  function get(url, parse) {
+    var req = new XMLHttpRequest();
+    req.open('GET', url + "lat=" + latitude + "&lon=" + longitude, true);
+    req.onload = function(e) {
+      if (req.readyState == 4) {
+        if (req.status == 200) {
+          console.log(req.responseText);
+          parse(JSON.parse(req.responseText));
+        } else {
+          console.log("Error");
+        }
+        requestDone();
       }
+    };
+    req.onerror = requestDone;
+    req.send(null);
+  }
+
+  get("http://api.openweathermap.org/data/2.5/weather?", function(response) {
+    current = [Math.round(response.main.temp - 273.15),
+      iconFromWeatherId(response.weather[0].id, response.weather[0].icon.slice(-1))];
+    console.log(response.name);
+  });
+  get("http://api.openweathermap.org/data/2.5/forecast?cnt=" + Math.ceil(FORECAST_HOURS / 3 + 1) + "&", function(response) {
+    list = response.list;
+  });
+  get("http://api.openweathermap.org/data/2.5/forecast/daily?cnt=2&", function(response) {
+    next = [Math.round(response.list[1].temp.day - 273.15),
+      iconFromWeatherId(response.list[1].weather[0].id, response.list[1].weather[0].icon.slice(-1))];
+    console.log(response.city.name);
+  });
+}
+
+function weatherData(weather) {
+  var start = weather.start;
+  var data = [WEATHER_DATA_VERSION, weather.next[0] & 0xff, weather.next[1],
+    start & 0xff, (start >>> 8) & 0xff, (start >>> 16) & 0xff, (start >>> 24) & 0xff,
+    weather.hours.length];
+  for (var i = 0; i < weather.hours.length; i++) {
+    data.push(weather.hours[i][0] & 0xff, weather.hours[i][1]);
+  }
+  return data;
+}
+
+// Hodina z bufferu, kterou hodinky právě zobrazují, nebo poslední dostupná
+function currentHour(weather, now) {
+  var index = Math.floor((now - weather.start) / HOUR);
+  return weather.hours[Math.max(0, Math.min(index, weather.hours.length - 1))];
+}
+
+// Poslední data, jejichž doručení hodinky potvrdily, a jejich obsah zprávy
+var lastAcked = null;
+var lastAckedPayload = null;
+
+function samePayload(a, b) {
+  if (!a || a.length !== b.length) {
+    return false;
+  }
+  for (var i = 0; i < a.length; i++) {
+    if (a[i] !== b[i]) {
+      return false;
     }
   }
-  req2.send(null);
+  return true;
+}
 
-  sendWeather();
+function temperatureChanged(before, after, delta) {
+  return (before === WEATHER_UNKNOWN) !== (after === WEATHER_UNKNOWN) || Math.abs(after - before) >= delta;
+}
+
+// Podstatná změna: jiná ikona, zjištění nebo ztráta teploty, rozdíl teplot aspoň o delta °C,
+// nebo hodinkám v bufferu dochází hodiny
+function materialChange(previous, weather, delta) {
+  if (!previous) {
+    return true;
+  }
+  var now = Date.now() / 1000;
+  if (previous.start + (previous.hours.length - FORECAST_LOW) * HOUR <= now) {
+    return true;
+  }
+  var before = currentHour(previous, now);
+  var after = currentHour(weather, now);
+  return before[1] !== after[1] || previous.next[1] !== weather.next[1] ||
+    temperatureChanged(before[0], after[0], delta) || temperatureChanged(previous.next[0], weather.next[0], delta);
 }
 
-function sendWeather() {
+// Žádost hodinek (answer) dostane odpověď vždy, jinak by hodinky čekaly na další interval;
+// stejná data jako minule potvrdí jen krátkou zprávou, podle které si hodinky obnoví čas příjmu.
+// Obnova z časovače v režimu push drobné výkyvy teploty neposílá
+function sendWeatherData(data, answer) {
+  if (!answer && !materialChange(lastAcked, data, loadSetting(setting("pushDelta")))) {
+    console.log("Weather unchanged, not sending");
+    return;
+  }
+  var payload = weatherData(data);
+  if (answer && samePayload(lastAckedPayload, payload)) {
+    console.log("Weather unchanged, confirming");
+    Pebble.sendAppMessage({"WEATHER_UNCHANGED_KEY":1});
+    return;
+  }
   Pebble.sendAppMessage({
-    "WEATHER_TEMPERATURE_KEY":temperature + "\u00B0C",
-    "WEATHER_ICON_KEY":icon,
-    "WEATHER_TEMPERATURE_NEXT_KEY":temperature_next + "\u00B0C",
-    "WEATHER_ICON_NEXT_KEY":icon_next}
+    "WEATHER_DATA_KEY":payload},
+    function(e) {
+      lastAcked = data;
+      lastAckedPayload = payload;
+    },
+    function(e) {
+      console.log("Weather not delivered");
+    }
   );
 }
 
-function locationSuccess(pos) {
+function sendWeather(answer) {
+  sendWeatherData(weather, answer);
+}
+
+// Cache posledního počasí v localStorage, klíčem je poloha zaokrouhlená na ~1 km
+var WEATHER_CACHE_KEY = "weatherCache";
+// Při menším posunu se počasí znovu nestahuje
+var MOVE_THRESHOLD = 2000;
+// Poloha stará až 10 minut stačí, přesnost na úrovni sítě také
+var LOCATION_OPTIONS = {
+  enableHighAccuracy: false,
+  maximumAge: 10 * 60 * 1000,
+  timeout: 30000
+};
+
+function locationKey(latitude, longitude) {
+  return latitude.toFixed(2) + "," + longitude.toFixed(2);
+}
+
+// Vzdálenost v metrech, na krátké vzdálenosti stačí rovinná aproximace
+function distance(lat1, lon1, lat2, lon2) {
+  var rad = Math.PI / 180;
+  var x = (lon2 - lon1) * rad * Math.cos((lat1 + lat2) / 2 * rad);
+  var y = (lat2 - lat1) * rad;
+  return Math.sqrt(x * x + y * y) * 6371000;
+}
+
+function cacheStore(latitude, longitude) {
+  localStorage.setItem(WEATHER_CACHE_KEY, JSON.stringify({
+    key: locationKey(latitude, longitude),
+    latitude: latitude,
+    longitude: longitude,
+    time: Date.now(),
+    weather: weather
+  }));
+}
+
+// Vrátí uložené počasí, pokud není starší než TTL a poloha se změnila jen málo
+function cacheLookup(latitude, longitude) {
+  var cached = JSON.parse(localStorage.getItem(WEATHER_CACHE_KEY) || "null");
+  if (!cached || !cached.weather.hours || Date.now() - cached.time > loadSetting(setting("weatherTtl")) * 60 * 1000) {
+    return null;
+  }
+  if (cached.key !== locationKey(latitude, longitude) &&
+      distance(cached.latitude, cached.longitude, latitude, longitude) > MOVE_THRESHOLD) {
+    return null;
+  }
+  return cached.weather;
+}
+
+function locationSuccess(pos, answer) {
   var coordinates = pos.coords;
-  fetchWeather(coordinates.latitude, coordinates.longitude);
+  var cached = cacheLookup(coordinates.latitude, coordinates.longitude);
+  if (cached) {
+    console.log("Weather from cache");
+    weather = cached;
+    sendWeather(answer);
+    return;
+  }
+  fetchWeather(coordinates.latitude, coordinates.longitude, answer);
 }
 
-function locationError(err) {
+// Bez polohy se nic neposílá, hodinky dál zobrazují uloženou předpověď
+function locationError(err, answer) {
   console.warn('location error (' + err.code + '): ' + err.message);
-  Pebble.sendAppMessage({
-    "WEATHER_TEMPERATURE_KEY":"N/A",
-    "WEATHER_TEMPERATURE_NEXT_KEY":"N/A"
-  });
 }
 
+// answer: obnova je odpovědí na žádost hodinek
+function refreshWeather(answer) {
+  window.navigator.geolocation.getCurrentPosition(
+    function(pos) { locationSuccess(pos, answer); },
+    function(err) { locationError(err, answer); },
+    LOCATION_OPTIONS);
+}
+
+// Počítadla událostí z hodinek, formát odpovídá energy_stats_write() v energy-stats.c
+var STATS_DATA_VERSION = 2;
+var STATS_HOURS = 24;
+var STATS_KEY = "energyStats";
+var STAT_LABELS = ["Tiky", "Překreslení", "Odeslané zprávy", "Přijaté zprávy", "Neodeslané zprávy",
+  "Načtené bitmapy", "Žádosti o počasí", "Vynechané žádosti o počasí", "Baterie (%)"];
+// Za počítadly posílají hodinky historii baterie od workeru, hodina bez vzorku má hodnotu 0xffff
+var STATS_BATTERY = 8;
+var BATTERY_UNKNOWN = 0xffff;
+
+// Jedno počítadlo ze zprávy: {index, count, hour: poslední hodina od epochy, values: [od nejstarší hodiny]}
+function decodeStats(data) {
+  if (data[0] !== STATS_DATA_VERSION) {
+    return null;
+  }
+  var values = [];
+  for (var pos = 7; values.length < STATS_HOURS; pos += 2) {
+    values.push(data[pos] | (data[pos + 1] << 8));
+  }
+  return {
+    index: data[1],
+    count: data[2],
+    hour: (data[3] | (data[4] << 8) | (data[5] << 16) | (data[6] << 24)) >>> 0,
+    values: values
+  };
+}
+
+// Počítadla chodí po jednom, uloží se, až dorazí poslední
+var pendingStats = null;
+
+// Vrací true, když jsou počítadla kompletní a uložená
+function storeStats(data) {
+  var chunk = decodeStats(data);
+  if (!chunk) {
+    return false;
+  }
+  if (chunk.index === 0) {
+    pendingStats = {hour: chunk.hour, counters: []};
+  }
+  // po ztracené části se čeká na další kompletní sadu, opakovaná část jen přepíše tu stejnou
+  if (!pendingStats || chunk.index > pendingStats.counters.length) {
+    pendingStats = null;
+    return false;
+  }
+  pendingStats.counters[chunk.index] = chunk.values;
+  if (chunk.index + 1 < chunk.count) {
+    return false;
+  }
+  var stats = pendingStats;
+  pendingStats = null;
+  localStorage.setItem(STATS_KEY, JSON.stringify(stats));
+  for (var i = 0; i < stats.counters.length; i++) {
+    console.log((STAT_LABELS[i] || "stat " + i) + ": " + stats.counters[i].join(" "));
+  }
+  return true;
+}
+
+var statsReceived = null;
+
 Pebble.addEventListener("appmessage",
   function(e) {
     console.log("Received a message from the watch.");
     console.log(e.payload);
-    window.navigator.geolocation.getCurrentPosition(locationSuccess, locationError);
+    if (e.payload.STATS_KEY !== undefined) {
+      if (storeStats(e.payload.STATS_KEY) && statsReceived) {
+        statsReceived();
+      }
+      return;
+    }
+    refreshWeather(true);
+  }
+);
+
+// V režimu push určuje obnovu počasí telefon a hodinky se samy neptají
+var pushTimer = null;
+// Nejkratší interval v minutách, stejný jako INTERVAL_MIN v weather-schedule.c
+var PUSH_INTERVAL_MIN = 10;
+
+// Interval jako na hodinkách: neplatná hodnota znamená výchozí, kratší než minimum se prodlouží
+function pushInterval() {
+  var minutes = loadSetting(setting("weatherInterval"));
+  if (!(minutes > 0)) {
+    minutes = setting("weatherInterval").value;
+  }
+  return Math.max(PUSH_INTERVAL_MIN, minutes);
+}
+
+function schedulePush() {
+  if (pushTimer) {
+    clearInterval(pushTimer);
+    pushTimer = null;
+  }
+  if (loadSetting(setting("weatherPush"))) {
+    pushTimer = setInterval(function() { refreshWeather(false); }, pushInterval() * 60 * 1000);
+    refreshWeather();
+  }
+}
+
+Pebble.addEventListener("ready",
+  function(e) {
+    schedulePush();
+  }
+);
+
+// Nastavení ciferníku, options jsou názvy hodnot 0, 1, ... pro výběr ze seznamu
+var SETTINGS = [
+  {
+    key: "locale",
+    appKey: "LOCALE_KEY",
+    label: "Jazyk a kalendář",
+    options: ["Čeština"],
+    value: 0
+  },
+  {
+    key: "secondsWindow",
+    appKey: "SECONDS_WINDOW_KEY",
+    label: "Sekundy po otočení zápěstím (s, 0 = stále)",
+    value: 30
+  },
+  {
+    key: "weatherInterval",
+    appKey: "WEATHER_INTERVAL_KEY",
+    label: "Základní interval obnovy počasí (min)",
+    value: 20
+  },
+  {
+    key: "lowBattery",
+    appKey: "LOW_BATTERY_KEY",
+    label: "Pod touto úrovní baterie obnovovat 4× řidčeji (%)",
+    value: 20
+  },
+  {
+    key: "weatherPush",
+    appKey: "WEATHER_PUSH_KEY",
+    label: "Počasí posílá telefon sám (jinak se ptají hodinky)",
+    options: ["Ne", "Ano"],
+    value: 0
+  },
+  {
+    key: "backgroundWorker",
+    appKey: "WORKER_KEY",
+    label: "Worker na pozadí, historie baterie",
+    options: ["Ne", "Ano"],
+    value: 1
+  },
+  {
+    key: "pushDelta",
+    label: "Změna teploty, kterou telefon pošle (°C)",
+    value: 2
+  },
+  {
+    key: "weatherTtl",
+    label: "Platnost uloženého počasí (min)",
+    value: 15
+  }
+];
+
+function setting(key) {
+  for (var i = 0; i < SETTINGS.length; i++) {
+    if (SETTINGS[i].key === key) {
+      return SETTINGS[i];
+    }
+  }
+  return null;
+}
+
+function loadSetting(setting) {
+  var stored = localStorage.getItem(setting.key);
+  return stored === null ? setting.value : parseInt(stored, 10);
+}
+
+// U baterie místo součtu nejnižší nabití za 24 hodin a poslední vzorek
+function batteryRow(values) {
+  var known = values.filter(function(value) {
+    return value !== BATTERY_UNKNOWN;
+  });
+  if (known.length === 0) {
+    return '';
+  }
+  return '<tr><td>' + STAT_LABELS[STATS_BATTERY] + '</td><td>min ' + Math.min.apply(null, known) +
+    '</td><td>' + known[known.length - 1] + '</td></tr>';
+}
+
+// Souhrn počítadel za 24 hodin a za poslední hodinu
+function statsTable() {
+  var stats = JSON.parse(localStorage.getItem(STATS_KEY) || "null");
+  if (!stats) {
+    return '';
+  }
+  var html = '<h3>Aktivita hodinek</h3><table><tr><th></th><th>24 h</th><th>poslední hodina</th></tr>';
+  for (var i = 0; i < stats.counters.length; i++) {
+    var values = stats.counters[i];
+    if (i === STATS_BATTERY) {
+      html += batteryRow(values);
+      continue;
+    }
+    var sum = 0;
+    for (var h = 0; h < values.length; h++) {
+      sum += values[h];
+    }
+    html += '<tr><td>' + (STAT_LABELS[i] || i) + '</td><td>' + sum + '</td><td>' + values[values.length - 1] + '</td></tr>';
+  }
+  return html + '</table>';
+}
+
+function configPage() {
+  var html = '<!DOCTYPE html><html><head><meta charset="utf-8">' +
+    '<meta name="viewport" content="width=device-width"><title>czDigiWatch</title></head><body>' +
+    '<form id="f">';
+  for (var i = 0; i < SETTINGS.length; i++) {
+    var value = loadSetting(SETTINGS[i]);
+    html += '<p><label>' + SETTINGS[i].label + '<br>';
+    if (SETTINGS[i].options) {
+      html += '<select name="' + SETTINGS[i].key + '">';
+      for (var j = 0; j < SETTINGS[i].options.length; j++) {
+        html += '<option value="' + j + '"' + (j === value ? ' selected' : '') + '>' + SETTINGS[i].options[j] + '</option>';
+      }
+      html += '</select>';
+    } else {
+      html += '<input type="number" min="0" name="' + SETTINGS[i].key + '" value="' + value + '">';
+    }
+    html += '</label></p>';
+  }
+  html += '<button type="submit">Uložit</button></form>' + statsTable() + '<script>' +
+    'document.getElementById("f").onsubmit=function(e){e.preventDefault();var r={};' +
+    'var els=this.elements;for(var i=0;i<els.length;i++){if(els[i].name){r[els[i].name]=els[i].value;}}' +
+    'document.location="pebblejs://close#"+encodeURIComponent(JSON.stringify(r));};' +
+    '</script></body></html>';
+  return 'data:text/html;charset=utf-8,' + encodeURIComponent(html);
+}
+
+// Jak dlouho čekat na počítadla z hodinek před otevřením nastavení
+var STATS_TIMEOUT = 3000;
+
+Pebble.addEventListener("showConfiguration",
+  function(e) {
+    var opened = false;
+    function open() {
+      if (!opened) {
+        opened = true;
+        statsReceived = null;
+        Pebble.openURL(configPage());
+      }
+    }
+    statsReceived = open;
+    setTimeout(open, STATS_TIMEOUT);
+    Pebble.sendAppMessage({"STATS_KEY": 1}, function(e) {}, open);
+  }
+);
+
+Pebble.addEventListener("webviewclosed",
+  function(e) {
+    if (!e.response) {
+      return;
+    }
+    var config = JSON.parse(decodeURIComponent(e.response));
+    var message = {};
+    for (var i = 0; i < SETTINGS.length; i++) {
+      var value = parseInt(config[SETTINGS[i].key], 10);
+      if (!isNaN(value)) {
+        localStorage.setItem(SETTINGS[i].key, value);
+        // nastavení bez appKey platí jen pro telefon
+        if (SETTINGS[i].appKey) {
+          message[SETTINGS[i].appKey] = value;
+        }
+      }
+    }
+    if (Object.keys(message).length > 0) {
+      Pebble.sendAppMessage(message);
+    }
+    schedulePush();
   }
-);
\ No newline at end of file
+);
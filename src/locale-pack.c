@@ -0,0 +1,219 @@
+#include <pebble.h>
+#include "locale-pack.h"
+
+// Binární sady generuje tools/locale_pack.py z resources/locales/*.txt, popis formátu je tam
+#define LOCALE_VERSION 1
+#define NAMEDAY_DAYS 366
+#define NO_NAME 0xffff
+
+static const uint32_t LOCALE_RESOURCES[LOCALE_COUNT] = {
+  RESOURCE_ID_LOCALE_CS
+};
+
+typedef struct __attribute__((packed)) {
+  uint8_t version;
+  uint8_t holiday_count;
+  uint16_t holidays;
+  uint16_t namedays;
+  uint16_t labels[LABEL_COUNT];
+  uint16_t weekdays[7];
+  uint16_t months[12];
+} LocaleHeader;
+
+enum {
+  HOLIDAY_FIXED,
+  HOLIDAY_EASTER
+};
+
+typedef struct __attribute__((packed)) {
+  uint8_t kind;
+  uint8_t reserved;
+  int16_t day;
+  uint16_t since;
+  uint16_t name;
+} HolidayRule;
+
+// V paměti zůstává jen hlavička, vše ostatní se čte ze zdroje podle potřeby
+static ResHandle pack;
+static size_t pack_size;
+static LocaleHeader header;
+
+static int leap_year(int year) {
+  return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+}
+
+// Přečte řetězec ukončený '\0' z offsetu ve zdroji, při chybě vrátí prázdný
+static void pack_string(uint16_t offset, char *buffer, size_t size) {
+  buffer[0] = '\0';
+  if (header.version != LOCALE_VERSION || offset >= pack_size) {
+    return;
+  }
+  size_t length = pack_size - offset < size - 1 ? pack_size - offset : size - 1;
+  length = resource_load_byte_range(pack, offset, (uint8_t *)buffer, length);
+  buffer[length] = '\0';
+}
+
+// Index dne v kalendáři přestupného roku (29. února má vždy index 59),
+// posun o future dní může přejít do dalšího roku, ten se vrací v year
+static int day_of_the_year(struct tm *t, int future, int *year) {
+  *year = t->tm_year+1900;
+  int day = t->tm_yday + future;
+  if (day >= 365) {
+    int days = leap_year(*year) ? 366 : 365;
+    if (day >= days) {
+      day -= days;
+      (*year)++;
+    }
+  }
+  if (day >= 59 && !leap_year(*year)) {
+    day++;
+  }
+  return day;
+}
+
+// Bitmapa svátků pro rok holiday_year, bit na každý index dne
+static uint32_t holidays[(366 + 31) / 32];
+static int holiday_year = -1;
+
+// Index Velikonoční neděle (gregoriánský computus, Meeus/Jones/Butcher)
+static int easter(int year) {
+  int a = year % 19;
+  int b = year / 100;
+  int c = year % 100;
+  int d = b / 4;
+  int e = b % 4;
+  int f = (b + 8) / 25;
+  int g = (b - f + 1) / 3;
+  int h = (19 * a + b - d - g + 15) % 30;
+  int i = c / 4;
+  int k = c % 4;
+  int l = (32 + 2 * e + 2 * i - h - k) % 7;
+  int m = (a + 11 * h + 22 * l) / 451;
+  int month = (h + l - 7 * m + 114) / 31;
+  int day = (h + l - 7 * m + 114) % 31 + 1;
+  // 1. března má index 60, 1. dubna 91
+  return (month == 3 ? 59 : 90) + day;
+}
+
+static void holiday_set(int day) {
+  holidays[day / 32] |= 1u << (day % 32);
+}
+
+static bool holiday_test(int day) {
+  return holidays[day / 32] & (1u << (day % 32));
+}
+
+// Pravidlo svátku přepočtené na index dne v roce year, -1 pokud v tom roce neplatí
+static int holiday_rule(int index, int year, uint16_t *name) {
+  HolidayRule rule;
+  if (resource_load_byte_range(pack, header.holidays + index * sizeof(rule), (uint8_t *)&rule, sizeof(rule)) !=
+      sizeof(rule) || year < rule.since) {
+    return -1;
+  }
+  if (name) {
+    *name = rule.name;
+  }
+  int day = rule.kind == HOLIDAY_EASTER ? easter(year) + rule.day : rule.day;
+  return day >= 0 && day < NAMEDAY_DAYS ? day : -1;
+}
+
+// Přepočítá bitmapu jen při změně roku
+static void holidays_build(int year) {
+  if (year == holiday_year) {
+    return;
+  }
+  memset(holidays, 0, sizeof(holidays));
+  for (int i = 0; i < header.holiday_count; i++) {
+    int day = holiday_rule(i, year, NULL);
+    if (day >= 0) {
+      holiday_set(day);
+    }
+  }
+  holiday_year = year;
+}
+
+void locale_load(int locale) {
+  if (locale < 0 || locale >= LOCALE_COUNT) {
+    locale = 0;
+  }
+  pack = resource_get_handle(LOCALE_RESOURCES[locale]);
+  pack_size = resource_size(pack);
+  if (resource_load_byte_range(pack, 0, (uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+      header.version != LOCALE_VERSION) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Neplatna jazykova sada %d", locale);
+    memset(&header, 0, sizeof(header));
+  }
+  holiday_year = -1;
+}
+
+void locale_label(LocaleLabel label, char *buffer, size_t size) {
+  pack_string(header.labels[label], buffer, size);
+}
+
+void locale_weekday(int wday, char *buffer, size_t size) {
+  pack_string(header.weekdays[wday], buffer, size);
+}
+
+void locale_month(int month, char *buffer, size_t size) {
+  pack_string(header.months[month], buffer, size);
+}
+
+bool public_holiday(struct tm *t, int future) {
+  int year;
+  int day = day_of_the_year(t, future, &year);
+  holidays_build(year);
+  return holiday_test(day);
+}
+
+bool movable_holiday(struct tm *t, int future, char *buffer, size_t size) {
+  int year;
+  int day = day_of_the_year(t, future, &year);
+  holidays_build(year);
+  if (!holiday_test(day)) {
+    return false;
+  }
+  for (int i = 0; i < header.holiday_count; i++) {
+    uint16_t name = NO_NAME;
+    if (holiday_rule(i, year, &name) == day && name != NO_NAME) {
+      pack_string(name, buffer, size);
+      return true;
+    }
+  }
+  return false;
+}
+
+int next_holiday(struct tm *t, int max_days) {
+  int year;
+  int day = day_of_the_year(t, 0, &year);
+  holidays_build(year);
+  bool common_year = !leap_year(year);
+  for (int future = 0; future <= max_days; future++, day++) {
+    if (day == 59 && common_year) {
+      day++;
+    }
+    // za koncem roku pokračuje bitmapa dalšího roku
+    if (day >= 366) {
+      day = 0;
+      year++;
+      holidays_build(year);
+      common_year = !leap_year(year);
+    }
+    if (holiday_test(day)) {
+      return future;
+    }
+  }
+  return -1;
+}
+
+void get_nameday(struct tm *t, int future, char *buffer, size_t size) {
+  int year;
+  int day = day_of_the_year(t, future, &year);
+  uint16_t offset;
+  if (day < 0 || day >= NAMEDAY_DAYS || header.namedays == 0 ||
+      resource_load_byte_range(pack, header.namedays + day * sizeof(offset), (uint8_t *)&offset, sizeof(offset)) !=
+      sizeof(offset)) {
+    snprintf(buffer, size, "Chyba");
+    return;
+  }
+  pack_string(offset, buffer, size);
+}
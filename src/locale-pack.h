@@ -0,0 +1,27 @@
+#pragma once
+#include <pebble.h>
+
+// Jazykové sady v pořadí zdrojů LOCALE_*, index se volí v nastavení
+#define LOCALE_COUNT 1
+// Buffery pro jméno a název svátku včetně '\0', delší řetězce tools/locale_pack.py odmítne
+#define LOCALE_NAMEDAY_SIZE 40
+#define LOCALE_HOLIDAY_SIZE 24
+
+typedef enum {
+  LABEL_NOW,
+  LABEL_TOMORROW,
+  LABEL_COUNT
+} LocaleLabel;
+
+// Načte hlavičku sady, při neplatném indexu použije první
+void locale_load(int locale);
+void locale_label(LocaleLabel label, char *buffer, size_t size);
+void locale_weekday(int wday, char *buffer, size_t size);
+void locale_month(int month, char *buffer, size_t size);
+
+bool public_holiday(struct tm *t, int future);
+// Název pohyblivého svátku (Velký pátek, Velikonoční pondělí) do bufferu, vrací false, pokud není
+bool movable_holiday(struct tm *t, int future, char *buffer, size_t size);
+// Počet dní do nejbližšího svátku (0 = dnes), -1 pokud není do max_days dní
+int next_holiday(struct tm *t, int max_days);
+void get_nameday(struct tm *t, int future, char *buffer, size_t size);
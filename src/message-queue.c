@@ -0,0 +1,132 @@
+#include <pebble.h>
+#include "message-queue.h"
+#include "energy-stats.h"
+
+#define QUEUE_SIZE 4
+// Odstup opakování: 5 s, 10 s, 20 s ... nejvýše 5 minut, plus náhodná odchylka do poloviny
+#define RETRY_BASE_MS 5000
+#define RETRY_MAX_MS (5 * 60 * 1000)
+
+static MessageWriter queue[QUEUE_SIZE];
+static int queue_length = 0;
+// Právě odesílaná část zprávy na začátku fronty a zda po ní následuje další
+static uint8_t queue_part = 0;
+static bool queue_more = false;
+static bool in_flight = false;
+static int attempts = 0;
+static AppTimer *retry_timer = NULL;
+
+static void queue_pop(void) {
+  queue_part = 0;
+  queue_length--;
+  memmove(&queue[0], &queue[1], queue_length * sizeof(MessageWriter));
+}
+
+static void queue_retry(void *data);
+
+static void queue_schedule_retry(void) {
+  uint32_t delay = RETRY_BASE_MS << (attempts < 6 ? attempts : 6);
+  if (delay > RETRY_MAX_MS) {
+    delay = RETRY_MAX_MS;
+  }
+  delay += rand() % (delay / 2);
+  attempts++;
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "Opakovani zpravy za %lu ms", (unsigned long)delay);
+  retry_timer = app_timer_register(delay, queue_retry, NULL);
+}
+
+static void queue_flush(void) {
+  if (in_flight || retry_timer || queue_length == 0) {
+    return;
+  }
+  // bez spojení se nic nezkouší, frontu odešle obnovení spojení
+  if (!connection_service_peek_pebble_app_connection()) {
+    return;
+  }
+
+  DictionaryIterator *iter;
+  if (app_message_outbox_begin(&iter) != APP_MSG_OK || iter == NULL) {
+    queue_schedule_retry();
+    return;
+  }
+  queue_more = queue[0](iter, queue_part);
+  dict_write_end(iter);
+  if (app_message_outbox_send() != APP_MSG_OK) {
+    queue_schedule_retry();
+    return;
+  }
+  in_flight = true;
+}
+
+static void queue_retry(void *data) {
+  retry_timer = NULL;
+  queue_flush();
+}
+
+static void outbox_sent_handler(DictionaryIterator *sent, void *context) {
+  energy_stats_count(STAT_MESSAGES_SENT);
+  in_flight = false;
+  attempts = 0;
+  if (queue_more) {
+    queue_part++;
+  } else {
+    queue_pop();
+  }
+  queue_flush();
+}
+
+static void outbox_failed_handler(DictionaryIterator *failed, AppMessageResult reason, void *context) {
+  in_flight = false;
+  energy_stats_count(STAT_MESSAGES_FAILED);
+  APP_LOG(APP_LOG_LEVEL_WARNING, "Zprava neodeslana: %d", (int)reason);
+  if (reason == APP_MSG_NOT_CONNECTED && !connection_service_peek_pebble_app_connection()) {
+    return;
+  }
+  queue_schedule_retry();
+}
+
+static void connection_handler(bool connected) {
+  if (!connected) {
+    return;
+  }
+  // po obnovení spojení se čekající zpráva pošle hned a jen jednou
+  if (retry_timer) {
+    app_timer_cancel(retry_timer);
+    retry_timer = NULL;
+  }
+  attempts = 0;
+  queue_flush();
+}
+
+void message_queue_init(void) {
+  srand(time(NULL));
+  app_message_register_outbox_sent(outbox_sent_handler);
+  app_message_register_outbox_failed(outbox_failed_handler);
+  connection_service_subscribe((ConnectionHandlers) {
+    .pebble_app_connection_handler = connection_handler
+  });
+}
+
+void message_queue_deinit(void) {
+  connection_service_unsubscribe();
+  if (retry_timer) {
+    app_timer_cancel(retry_timer);
+    retry_timer = NULL;
+  }
+  queue_length = 0;
+  queue_part = 0;
+}
+
+void message_queue_send(MessageWriter writer) {
+  for (int i = 0; i < queue_length; i++) {
+    if (queue[i] == writer) {
+      return;
+    }
+  }
+  if (queue_length == QUEUE_SIZE) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Fronta zprav je plna");
+    return;
+  }
+  queue[queue_length++] = writer;
+  queue_flush();
+}
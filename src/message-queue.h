@@ -0,0 +1,13 @@
+#pragma once
+#include <pebble.h>
+
+// Zapíše část part (od 0) obsahu zprávy do připraveného slovníku, vrací true, pokud následuje další
+// část. Části se posílají po jedné, aby outbox stačil na tu největší, ne na celou zprávu.
+typedef bool (*MessageWriter)(DictionaryIterator *iter, uint8_t part);
+
+// Zaregistruje callbacky outboxu a sledování spojení s telefonem
+void message_queue_init(void);
+void message_queue_deinit(void);
+// Zařadí zprávu k odeslání, stejná zpráva je ve frontě nejvýše jednou.
+// Při chybě se opakuje s exponenciálním odstupem, bez spojení čeká na jeho obnovení.
+void message_queue_send(MessageWriter writer);
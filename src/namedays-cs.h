@@ -1,5 +0,0 @@
-#pragma once
-#include <pebble.h>
-
-bool public_holiday(struct tm *t, int future);
-char *get_nameday(struct tm *t, int future);
\ No newline at end of file
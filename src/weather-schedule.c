@@ -0,0 +1,132 @@
+#include <pebble.h>
+#include "weather-schedule.h"
+#include "energy-stats.h"
+
+// Meze intervalu v minutách
+#define INTERVAL_MIN 10
+#define INTERVAL_MAX (6 * 60)
+// Noc, kdy se počasí mění méně a nikdo se nedívá
+#define NIGHT_START 0
+#define NIGHT_END 6
+// Změna měření (°C, změna ikony se počítá za 3), od které se interval zkracuje
+#define CHANGE_LARGE 3
+
+static WeatherPolicy policy;
+static void (*request_callback)(void);
+static AppTimer *timer = NULL;
+static time_t timer_due = 0;
+// Do kdy platí poslední přijatá data, dřív se nová nežádají
+static time_t valid_until = 0;
+// Kolikrát po sobě se počasí téměř nezměnilo
+static int stable_readings = 0;
+
+static bool user_sleeping(void) {
+#if defined(PBL_HEALTH)
+  return health_service_peek_current_activities() & (HealthActivitySleep | HealthActivityRestfulSleep);
+#else
+  return false;
+#endif
+}
+
+// Interval do další žádosti v minutách
+static uint32_t next_interval(void) {
+  uint32_t interval = policy.interval;
+
+  // stálé počasí se zjišťuje řidčeji, prudká změna interval zkrátí
+  if (stable_readings < 0) {
+    interval /= 2;
+  } else {
+    interval <<= (stable_readings < 3 ? stable_readings : 3);
+  }
+
+  BatteryChargeState battery = battery_state_service_peek();
+  if (!battery.is_plugged && battery.charge_percent <= policy.low_battery) {
+    interval *= 4;
+  }
+
+  time_t now = time(NULL);
+  struct tm *t = localtime(&now);
+  if (t->tm_hour >= NIGHT_START && t->tm_hour < NIGHT_END) {
+    interval *= 3;
+  }
+
+  if (interval < INTERVAL_MIN) {
+    interval = INTERVAL_MIN;
+  } else if (interval > INTERVAL_MAX) {
+    interval = INTERVAL_MAX;
+  }
+  return interval;
+}
+
+static void schedule(uint32_t seconds);
+
+static void timer_callback(void *data) {
+  timer = NULL;
+  // ve spánku se žádost vynechá, bez spojení ji fronta zpráv podrží do připojení
+  if (user_sleeping()) {
+    energy_stats_count(STAT_WEATHER_SKIPPED);
+  } else {
+    request_callback();
+  }
+  schedule(next_interval() * 60);
+}
+
+static void schedule(uint32_t seconds) {
+  if (timer) {
+    app_timer_cancel(timer);
+    timer = NULL;
+  }
+  timer_due = 0;
+  if (!policy.push) {
+    timer = app_timer_register(seconds * 1000, timer_callback, NULL);
+    timer_due = time(NULL) + seconds;
+  }
+}
+
+// Další žádost za interval, nejdřív ale po skončení platnosti posledních dat
+static void schedule_next(void) {
+  uint32_t interval = next_interval() * 60;
+  time_t now = time(NULL);
+  uint32_t valid_for = valid_until > now ? valid_until - now : 0;
+  schedule(valid_for > interval ? valid_for : interval);
+}
+
+void weather_schedule_init(WeatherPolicy initial_policy, void (*request)(void), uint32_t first_delay) {
+  policy = initial_policy;
+  request_callback = request;
+  valid_until = time(NULL) + first_delay;
+  schedule(first_delay);
+}
+
+void weather_schedule_deinit(void) {
+  if (timer) {
+    app_timer_cancel(timer);
+    timer = NULL;
+  }
+}
+
+// Uložení nastavení beze změny pravidel plánování nemění
+void weather_schedule_set_policy(WeatherPolicy new_policy) {
+  if (new_policy.interval == policy.interval && new_policy.low_battery == policy.low_battery &&
+      new_policy.push == policy.push) {
+    return;
+  }
+  policy = new_policy;
+  schedule_next();
+}
+
+void weather_schedule_reading(int change, uint32_t valid_for) {
+  if (change >= CHANGE_LARGE) {
+    stable_readings = -1;
+  } else if (change <= 1) {
+    stable_readings = stable_readings < 0 ? 0 : stable_readings + 1;
+  } else {
+    stable_readings = 0;
+  }
+  valid_until = time(NULL) + valid_for;
+  schedule_next();
+}
+
+time_t weather_schedule_next(void) {
+  return timer ? timer_due : 0;
+}
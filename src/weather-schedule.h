@@ -0,0 +1,22 @@
+#pragma once
+#include <pebble.h>
+
+// Pravidla plánování počasí, intervaly v minutách
+typedef struct {
+  uint16_t interval;
+  uint8_t low_battery;
+  // počasí posílá telefon sám, hodinky se neptají
+  bool push;
+} WeatherPolicy;
+
+#define WEATHER_POLICY_DEFAULT ((WeatherPolicy) { .interval = 20, .low_battery = 20, .push = false })
+
+// Naplánuje první žádost za first_delay sekund, další podle pravidel
+void weather_schedule_init(WeatherPolicy policy, void (*request)(void), uint32_t first_delay);
+void weather_schedule_deinit(void);
+void weather_schedule_set_policy(WeatherPolicy policy);
+// Volá se po přijetí počasí s velikostí změny proti minulému měření a dobou platnosti
+// přijatých dat v sekundách, další žádost přijde nejdřív po jejím uplynutí
+void weather_schedule_reading(int change, uint32_t valid_for);
+// Kdy přijde další žádost, 0 pokud žádná není naplánována
+time_t weather_schedule_next(void);
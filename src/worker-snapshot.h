@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+
+// Stav, který ciferníku udržuje worker na pozadí, sdílí ho s ním přes persist.
+// Zapisuje jen worker, ciferník ho čte při spuštění a změny posílá zprávou.
+#define WORKER_SNAPSHOT_KEY 1000
+#define WORKER_SNAPSHOT_VERSION 2
+// Hodinové vzorky baterie za poslední den, hodina bez vzorku má hodnotu WORKER_BATTERY_UNKNOWN.
+// Ciferník je posílá ve formátu počítadel, počet musí odpovídat STATS_HOURS.
+#define WORKER_BATTERY_SAMPLES 24
+#define WORKER_BATTERY_UNKNOWN 0xff
+
+// Zprávy od ciferníku pro worker
+enum {
+  // data0 a data1: dolní a horní polovina času další obnovy počasí
+  WORKER_MESSAGE_WEATHER_DUE
+};
+
+typedef struct __attribute__((packed)) {
+  uint8_t version;
+  // hodina od epochy posledního vzorku, vzorek hodiny h je v battery_samples[h % WORKER_BATTERY_SAMPLES]
+  uint32_t battery_hour;
+  // nabití v procentech na začátku hodiny
+  uint8_t battery_samples[WORKER_BATTERY_SAMPLES];
+  // kdy ciferník plánoval další žádost o počasí, 0 = neznámo
+  uint32_t weather_due;
+} WorkerSnapshot;
@@ -0,0 +1,143 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# Skládá ikony do jednoho PNG (sprite atlas) a generuje hlavičku s tabulkou
+# obdélníků jednotlivých ikon.
+#
+# Vstup: 8bitová PNG (šedá, RGB, s alfou nebo bez), výstup: RGB PNG a C hlavička
+# s výčtem ICON_<JMÉNO> a polem ICON_ATLAS. Jméno ikony vzniká z názvu
+# souboru (battery_ch_10.png -> ICON_BATTERY_CH_10).
+#
+# Použití: atlas.py <atlas.png> <hlavička.h> <ikona.png>...
+
+import io
+import os
+import struct
+import sys
+import zlib
+
+ATLAS_WIDTH = 128
+PNG_SIGNATURE = b'\x89PNG\r\n\x1a\n'
+CHANNELS = {0: 1, 2: 3, 4: 2, 6: 4}
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def read_png(path):
+    """Vrátí (šířka, výška, řádky RGB bajtů)."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:8] != PNG_SIGNATURE:
+        raise ValueError('%s: není PNG' % path)
+    pos = 8
+    idat = b''
+    while pos < len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        if kind == b'IHDR':
+            width, height, depth, color, _, _, interlace = struct.unpack('>IIBBBBB', body)
+        elif kind == b'IDAT':
+            idat += body
+        pos += 12 + length
+    if depth != 8 or color not in CHANNELS or interlace:
+        raise ValueError('%s: podporována jsou jen neprokládaná 8bitová PNG bez palety' % path)
+
+    bpp = CHANNELS[color]
+    stride = width * bpp
+    raw = bytearray(zlib.decompress(idat))
+    rows = []
+    prev = bytearray(stride)
+    for y in range(height):
+        start = y * (stride + 1)
+        kind = raw[start]
+        row = raw[start + 1:start + 1 + stride]
+        for x in range(stride):
+            a = row[x - bpp] if x >= bpp else 0
+            b = prev[x]
+            c = prev[x - bpp] if x >= bpp else 0
+            if kind == 1:
+                row[x] = (row[x] + a) & 0xff
+            elif kind == 2:
+                row[x] = (row[x] + b) & 0xff
+            elif kind == 3:
+                row[x] = (row[x] + (a + b) // 2) & 0xff
+            elif kind == 4:
+                row[x] = (row[x] + paeth(a, b, c)) & 0xff
+        prev = row
+        rgb = bytearray()
+        for x in range(width):
+            pixel = row[x * bpp:(x + 1) * bpp]
+            rgb += pixel[:3] if bpp >= 3 else pixel[:1] * 3
+        rows.append(rgb)
+    return width, height, rows
+
+
+def write_png(path, width, height, rows):
+    def chunk(kind, body):
+        return struct.pack('>I', len(body)) + kind + body + struct.pack('>I', zlib.crc32(kind + body) & 0xffffffff)
+    raw = b''.join(b'\0' + bytes(row) for row in rows)
+    with open(path, 'wb') as f:
+        f.write(PNG_SIGNATURE)
+        f.write(chunk(b'IHDR', struct.pack('>IIBBBBB', width, height, 8, 2, 0, 0, 0)))
+        f.write(chunk(b'IDAT', zlib.compress(raw, 9)))
+        f.write(chunk(b'IEND', b''))
+
+
+def icon_name(path):
+    name = os.path.splitext(os.path.basename(path))[0]
+    return 'ICON_' + name.upper().replace('-', '_')
+
+
+def pack(icons):
+    """Police podle výšky: ikony se řadí zleva doprava, nová řada při přetečení šířky."""
+    rects = {}
+    x = y = shelf = 0
+    for name, (width, height, _) in sorted(icons.items(), key=lambda item: (-item[1][1], item[0])):
+        if x + width > ATLAS_WIDTH:
+            x, y, shelf = 0, y + shelf, 0
+        rects[name] = (x, y, width, height)
+        x += width
+        shelf = max(shelf, height)
+    return rects, y + shelf
+
+
+def generate(atlas, header, sources):
+    icons = dict((icon_name(path), read_png(path)) for path in sources)
+    rects, height = pack(icons)
+
+    rows = [bytearray(ATLAS_WIDTH * 3) for _ in range(height)]
+    for name, (x, y, width, icon_height) in rects.items():
+        for row in range(icon_height):
+            rows[y + row][x * 3:(x + width) * 3] = icons[name][2][row]
+    write_png(atlas, ATLAS_WIDTH, height, rows)
+
+    names = sorted(rects)
+    lines = [
+        u'// Vygenerováno nástrojem tools/atlas.py, neupravovat.',
+        u'#pragma once',
+        u'#include <pebble.h>',
+        u'',
+        u'typedef enum {',
+    ]
+    lines += [u'  %s,' % name for name in names]
+    lines += [
+        u'  ICON_COUNT',
+        u'} Icon;',
+        u'',
+        u'// Obdélníky ikon v RESOURCE_ID_IMAGE_ICON_ATLAS (%dx%d)' % (ATLAS_WIDTH, height),
+        u'static const GRect ICON_ATLAS[ICON_COUNT] = {',
+    ]
+    lines += [u'  [%s] = {{%d, %d}, {%d, %d}},' % ((name,) + rects[name]) for name in names]
+    lines.append(u'};')
+    with io.open(header, 'w', encoding='utf-8') as f:
+        f.write(u'\n'.join(lines) + u'\n')
+
+
+if __name__ == '__main__':
+    generate(sys.argv[1], sys.argv[2], sys.argv[3:])
@@ -0,0 +1,327 @@
+// Mikrobenchmarky horkých cest ciferníku, sestavení a spuštění: make -C tools/bench
+//
+// Ciferník se vkládá celý, benchmarky tak volají přímo jeho statické funkce. Každý běží
+// aspoň BENCH_MIN_NS a vypisuje čas na volání, alokace na haldě aplikace, invalidace vrstvy
+// (layer_mark_dirty), vykreslené texty a bitmapy a odeslané zprávy, vše na jedno volání.
+// main() ciferníku nic nevrací, což je u main v pořádku, po přejmenování už ne.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main czdigiwatch_main
+#include "../../src/czDigiWatch.c"
+#undef main
+#pragma GCC diagnostic pop
+
+#include "pebble-stub.h"
+#include "namedays-switch.h"
+
+#define BENCH_MIN_NS 200000000LL
+// Přestupný a následující běžný rok
+#define BENCH_YEAR 2024
+#define BENCH_DAYS (366 + 365)
+
+typedef void (*BenchOp)(int i);
+
+static struct tm days[BENCH_DAYS];
+static struct tm tick;
+// Půlnoc prvního dne
+static time_t day_start;
+
+static int64_t now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Volá op(0) .. op(ops - 1) dokola, dokud neuplyne BENCH_MIN_NS
+static void bench(const char *name, BenchOp op, int ops) {
+  int64_t calls = 0;
+  stub_reset();
+  int64_t start = now_ns();
+  int64_t elapsed;
+  do {
+    for (int i = 0; i < ops; i++) {
+      op(i);
+    }
+    calls += ops;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  printf("%-32s %10.1f %9.2f %9.2f %9.2f %9.2f %9.2f\n", name, (double)elapsed / calls,
+         (double)stub_counters.allocations / calls, (double)stub_counters.invalidations / calls,
+         (double)stub_counters.text_draws / calls, (double)stub_counters.bitmap_draws / calls,
+         (double)stub_counters.messages_sent / calls);
+}
+
+static void days_init(void) {
+  for (int i = 0; i < BENCH_DAYS; i++) {
+    struct tm t = { .tm_year = BENCH_YEAR - 1900, .tm_mday = 1 + i, .tm_hour = 12 };
+    time_t time = mktime(&t);
+    days[i] = *localtime(&time);
+  }
+  day_start = mktime(&days[0]) - days[0].tm_hour * SECONDS_PER_HOUR;
+}
+
+// Sekundy jednoho dne, tik po tiku
+static void tick_set(int i) {
+  tick.tm_sec = i % 60;
+  tick.tm_min = i / 60 % 60;
+  tick.tm_hour = i / 3600 % 24;
+}
+
+static void op_update_time(int i) {
+  tick_set(i);
+  update_time(&tick);
+}
+
+// Původní update_time() před tabulkou dvojic číslic: localtime() a strftime() při každém
+// tiku. Čas se místo time(NULL) bere ze stejného dne jako u op_update_time.
+static void op_update_time_strftime(int i) {
+  time_t now = day_start + i;
+  struct tm *t = localtime(&now);
+
+  char digits[sizeof(view.digits)];
+
+  if(clock_is_24h_style() == true) {
+    strftime(digits, sizeof(digits), "%H:%M", t);
+  } else {
+    strftime(digits, sizeof(digits), "%I:%M", t);
+  }
+  view_set_text(REGION_DIGITS, view.digits, sizeof(view.digits), digits);
+
+  if (seconds_visible) {
+    char secs[sizeof(view.seconds)];
+    strftime(secs, sizeof(secs), "%S", t);
+    view_set_text(REGION_SECONDS, view.seconds, sizeof(view.seconds), secs);
+  }
+}
+
+static void op_tick(int i) {
+  tick_set(i);
+  TimeUnits units = SECOND_UNIT;
+  if (tick.tm_sec == 0) {
+    units |= MINUTE_UNIT;
+  }
+  refresh_every_second(&tick, units);
+}
+
+static void op_update_day(int i) {
+  update_day(&days[i]);
+}
+
+static void op_get_nameday(int i) {
+  char nameday[LOCALE_NAMEDAY_SIZE];
+  get_nameday(&days[i], 0, nameday, sizeof(nameday));
+}
+
+// Původní switch, jméno se kopíruje do bufferu stejně jako u jazykové sady
+static void op_get_nameday_switch(int i) {
+  char nameday[LOCALE_NAMEDAY_SIZE];
+  snprintf(nameday, sizeof(nameday), "%s", get_nameday_switch(&days[i], 0));
+}
+
+static void op_public_holiday(int i) {
+  public_holiday(&days[i], 0);
+}
+
+// Nejbližší svátek nejvýše za tolik dní, hledání projde i přelom roku
+#define NEXT_HOLIDAY_DAYS 60
+
+static void op_next_holiday(int i) {
+  next_holiday(&days[i], NEXT_HOLIDAY_DAYS);
+}
+
+static void op_render(int i) {
+  stub_render();
+}
+
+// Zprávy od telefonu, sestavené předem ve formátu firmwaru
+
+typedef struct {
+  uint8_t buffer[128];
+  DictionaryIterator iter;
+} Message;
+
+static Message weather_messages[2];
+static Message unchanged_message;
+static Message settings_message;
+static Message locale_message;
+static Message stats_message;
+
+static void message_begin(Message *message) {
+  dict_write_begin(&message->iter, message->buffer, sizeof(message->buffer));
+}
+
+static void message_end(Message *message) {
+  dict_write_end(&message->iter);
+}
+
+static void messages_init(void) {
+  time_t now = time(NULL);
+  for (int variant = 0; variant < 2; variant++) {
+    WeatherData weather = {
+      .version = WEATHER_DATA_VERSION,
+      .temperature_next = 20 + variant,
+      .icon_next = 0,
+      .start = now - now % SECONDS_PER_HOUR,
+      .count = FORECAST_HOURS
+    };
+    for (int h = 0; h < FORECAST_HOURS; h++) {
+      weather.hours[h] = (Forecast) { .temperature = 10 + h + variant, .icon = (h + variant) % 4 };
+    }
+    message_begin(&weather_messages[variant]);
+    dict_write_data(&weather_messages[variant].iter, WEATHER_DATA_KEY, (const uint8_t *)&weather, sizeof(weather));
+    message_end(&weather_messages[variant]);
+  }
+
+  message_begin(&unchanged_message);
+  dict_write_uint8(&unchanged_message.iter, WEATHER_UNCHANGED_KEY, 1);
+  message_end(&unchanged_message);
+
+  message_begin(&settings_message);
+  dict_write_int32(&settings_message.iter, SECONDS_WINDOW_KEY, 30);
+  dict_write_int32(&settings_message.iter, WEATHER_INTERVAL_KEY, 20);
+  dict_write_int32(&settings_message.iter, LOW_BATTERY_KEY, 20);
+  dict_write_int32(&settings_message.iter, WEATHER_PUSH_KEY, 0);
+  message_end(&settings_message);
+
+  message_begin(&locale_message);
+  dict_write_int32(&locale_message.iter, LOCALE_KEY, 0);
+  message_end(&locale_message);
+
+  message_begin(&stats_message);
+  dict_write_int32(&stats_message.iter, STATS_KEY, 1);
+  message_end(&stats_message);
+}
+
+static void op_inbox_weather(int i) {
+  in_received_handler(&weather_messages[i % 2].iter, NULL);
+}
+
+static void op_inbox_unchanged(int i) {
+  in_received_handler(&unchanged_message.iter, NULL);
+}
+
+static void op_inbox_settings(int i) {
+  in_received_handler(&settings_message.iter, NULL);
+}
+
+static void op_inbox_locale(int i) {
+  in_received_handler(&locale_message.iter, NULL);
+}
+
+// Žádost o počítadla včetně potvrzení všech odeslaných částí
+static void op_inbox_stats(int i) {
+  in_received_handler(&stats_message.iter, NULL);
+  while (stub_outbox_ack()) {
+  }
+}
+
+// Kontroly
+
+static int check_failures;
+
+static void check(bool ok, const char *what, const struct tm *t, int got, int expected) {
+  if (!ok) {
+    check_failures++;
+    fprintf(stderr, "%s %d.%d.%d: %d, ocekavano %d\n", what, t->tm_mday, t->tm_mon + 1, t->tm_year + 1900, got,
+            expected);
+  }
+}
+
+// next_holiday() proti dennímu public_holiday() pro každý den, přes 28./29. 2. i 31. 12.
+static void check_next_holiday(void) {
+  for (int i = 0; i + NEXT_HOLIDAY_DAYS < BENCH_DAYS; i++) {
+    int expected = -1;
+    for (int future = 0; future <= NEXT_HOLIDAY_DAYS && expected < 0; future++) {
+      if (public_holiday(&days[i + future], 0)) {
+        expected = future;
+      }
+    }
+    int got = next_holiday(&days[i], NEXT_HOLIDAY_DAYS);
+    check(got == expected, "next_holiday", &days[i], got, expected);
+  }
+}
+
+// Pevné případy: konec roku, únor přestupného a běžného roku
+static void check_next_holiday_dates(void) {
+  static const struct {
+    int year;
+    int mon;
+    int mday;
+    int expected;
+  } CASES[] = {
+    { 2024, 12, 27, 5 },   // 1. 1. 2025
+    { 2024, 12, 31, 1 },
+    { 2025, 1, 1, 0 },
+    { 2024, 2, 28, 30 },   // Velký pátek 29. 3. 2024
+    { 2024, 2, 29, 29 },
+    { 2025, 2, 28, 49 },   // Velký pátek 18. 4. 2025
+    { 2025, 3, 1, 48 },
+  };
+  for (unsigned int i = 0; i < ARRAY_LENGTH(CASES); i++) {
+    struct tm t = { .tm_year = CASES[i].year - 1900, .tm_mon = CASES[i].mon - 1, .tm_mday = CASES[i].mday,
+                    .tm_hour = 12 };
+    mktime(&t);
+    int got = next_holiday(&t, NEXT_HOLIDAY_DAYS);
+    check(got == CASES[i].expected, "next_holiday", &t, got, CASES[i].expected);
+  }
+}
+
+int main(int argc, char **argv) {
+  const char *build = argc > 1 ? argv[1] : "build";
+  char path[256];
+  snprintf(path, sizeof(path), "%s/locale-cs.bin", build);
+  if (!stub_resource_file(RESOURCE_ID_LOCALE_CS, path)) {
+    fprintf(stderr, "Nelze nacist %s\n", path);
+    return 1;
+  }
+  snprintf(path, sizeof(path), "%s/icon-atlas.png", build);
+  if (!stub_resource_file(RESOURCE_ID_IMAGE_ICON_ATLAS, path)) {
+    fprintf(stderr, "Nelze nacist %s\n", path);
+    return 1;
+  }
+  stub_set_verbose(getenv("BENCH_LOG") != NULL);
+  setenv("TZ", "UTC", 1);
+  tzset();
+  days_init();
+  messages_init();
+
+  stub_reset();
+  init();
+  size_t heap_loaded = stub_heap_in_use();
+  uint32_t init_allocations = stub_counters.allocations;
+  // první snímek vytvoří cache číslic a denní bitmapu
+  stub_render();
+  size_t heap_rendered = stub_heap_in_use();
+  tick = days[0];
+
+  check_next_holiday();
+  check_next_holiday_dates();
+  if (check_failures) {
+    fprintf(stderr, "%d kontrol selhalo\n", check_failures);
+    return 1;
+  }
+
+  printf("%-32s %10s %9s %9s %9s %9s %9s\n", "benchmark", "ns/op", "alloc/op", "dirty/op", "text/op",
+         "bitmap/op", "msgs/op");
+  bench("update_time", op_update_time, SECONDS_PER_DAY);
+  bench("update_time strftime (baseline)", op_update_time_strftime, SECONDS_PER_DAY);
+  bench("refresh_every_second", op_tick, SECONDS_PER_DAY);
+  bench("update_day", op_update_day, BENCH_DAYS);
+  bench("get_nameday (every day)", op_get_nameday, BENCH_DAYS);
+  bench("get_nameday switch (baseline)", op_get_nameday_switch, BENCH_DAYS);
+  bench("public_holiday (every day)", op_public_holiday, BENCH_DAYS);
+  bench("next_holiday (every day)", op_next_holiday, BENCH_DAYS);
+  bench("canvas redraw", op_render, 1);
+  bench("in_received_handler weather", op_inbox_weather, 2);
+  bench("in_received_handler unchanged", op_inbox_unchanged, 1);
+  bench("in_received_handler settings", op_inbox_settings, 1);
+  bench("in_received_handler locale", op_inbox_locale, 1);
+  bench("in_received_handler stats", op_inbox_stats, 1);
+
+  printf("\nAppMessage: inbox %u B, outbox %u B\n", (unsigned)stub_inbox_size(), (unsigned)stub_outbox_size());
+  deinit();
+  printf("heap: %zu B after init (%u allocations), %zu B after first frame, %zu B left after deinit\n",
+         heap_loaded, (unsigned)init_allocations, heap_rendered, stub_heap_in_use());
+  return 0;
+}
@@ -1,11 +1,13 @@
+// Původní get_nameday() ze src/namedays-cs.c (switch přes 366 dní), jen pro srovnání velikosti
+// a rychlosti s jazykovou sadou v benchmarku, ciferník ho nepoužívá.
 #include <pebble.h>
-#include "namedays-cs.h"
+#include "namedays-switch.h"
 
-int leap_year(int year) {
+static int leap_year(int year) {
   return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
 }
 
-int day_of_the_year(struct tm *t) {
+static int day_of_the_year(struct tm *t) {
   if (t->tm_yday+1 > 59 && !leap_year(t->tm_year+1900)) {
     return t->tm_yday+1;
   } else {
@@ -13,33 +15,7 @@ int day_of_the_year(struct tm *t) {
   }
 }
 
-bool public_holiday(struct tm *t, int future) {
-  int day = day_of_the_year(t) + future;
-  // nepravidelné svátky - Velikonoce do roku 2018
-  if ((t->tm_year+1900 == 2016 && day == 87) || (t->tm_year+1900 == 2017 && day == 107) ||
-      (t->tm_year+1900 == 2018 && day == 92)) {
-    return true;
-  }
-  // pravidelné svátky
-  switch (day) {
-    case 0: // nový rok
-    case 121: // 1. květen
-    case 128: // 8. května
-    case 186: // 5. července | Cyril a Metoděj
-    case 187: // 6. července | Upálení Jana Husa
-    case 271: // 28. září | Sv. Václav
-    case 301: // 28. října | Den vzniku sam. čs státu
-    case 321: // 17. listopadu | Den boje za svobou a demokracii
-    case 358: // 24. prosince | Vánoce
-    case 359: // 25. prosínce | 1. svátek vánoční
-    case 360: // 26. prosince | 2. svátek vánoční
-      return true;
-    default:
-      return false;
-  }
-}
-
-char *get_nameday(struct tm *t, int future) {
+const char *get_nameday_switch(struct tm *t, int future) {
   int day = day_of_the_year(t) + future;
   switch (day) {
     case 0:
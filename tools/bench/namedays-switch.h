@@ -0,0 +1,4 @@
+#pragma once
+#include <pebble.h>
+
+const char *get_nameday_switch(struct tm *t, int future);
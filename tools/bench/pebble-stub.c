@@ -0,0 +1,748 @@
+// Náhrada firmwaru Pebble pro sestavení ciferníku na počítači. Nic nevykresluje, jen počítá
+// volání (pebble-stub.h), drží persist v paměti a zdroje čte ze souborů.
+#define PEBBLE_STUB_IMPLEMENTATION
+#include <stdarg.h>
+#include "pebble-stub.h"
+
+// Halda aplikace na Aplite, jen pro heap_bytes_free()
+#define STUB_HEAP_SIZE (24 * 1024)
+#define PERSIST_DATA_MAX_LENGTH 256
+#define PERSIST_ENTRIES 64
+#define RESOURCE_ENTRIES 8
+#define LAYER_CHILDREN 4
+#define E_DOES_NOT_EXIST (-4)
+
+StubCounters stub_counters;
+
+static size_t heap_in_use;
+static bool verbose;
+
+void stub_reset(void) {
+  memset(&stub_counters, 0, sizeof(stub_counters));
+}
+
+size_t stub_heap_in_use(void) {
+  return heap_in_use;
+}
+
+void stub_set_verbose(bool value) {
+  verbose = value;
+}
+
+// Halda s počítadlem, před každým blokem je jeho velikost
+
+typedef union {
+  size_t size;
+  max_align_t align;
+} BlockHeader;
+
+void *stub_malloc(size_t size) {
+  BlockHeader *block = malloc(sizeof(BlockHeader) + size);
+  if (!block) {
+    return NULL;
+  }
+  block->size = size;
+  heap_in_use += size;
+  stub_counters.allocations++;
+  return block + 1;
+}
+
+void *stub_calloc(size_t count, size_t size) {
+  void *ptr = stub_malloc(count * size);
+  if (ptr) {
+    memset(ptr, 0, count * size);
+  }
+  return ptr;
+}
+
+void stub_free(void *ptr) {
+  if (!ptr) {
+    return;
+  }
+  BlockHeader *block = (BlockHeader *)ptr - 1;
+  heap_in_use -= block->size;
+  stub_counters.frees++;
+  free(block);
+}
+
+void *stub_realloc(void *ptr, size_t size) {
+  void *resized = stub_malloc(size);
+  if (resized && ptr) {
+    size_t old_size = ((BlockHeader *)ptr - 1)->size;
+    memcpy(resized, ptr, old_size < size ? old_size : size);
+    stub_free(ptr);
+  }
+  return resized;
+}
+
+size_t heap_bytes_used(void) {
+  return heap_in_use;
+}
+
+size_t heap_bytes_free(void) {
+  return heap_in_use < STUB_HEAP_SIZE ? STUB_HEAP_SIZE - heap_in_use : 0;
+}
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...) {
+  stub_counters.logs++;
+  if (!verbose) {
+    return;
+  }
+  va_list args;
+  va_start(args, fmt);
+  fprintf(stderr, "%s:%d: ", src_filename, src_line_number);
+  vfprintf(stderr, fmt, args);
+  fputc('\n', stderr);
+  va_end(args);
+}
+
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms) {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  uint16_t ms = now.tv_nsec / 1000000;
+  if (t_utc) {
+    *t_utc = now.tv_sec;
+  }
+  if (out_ms) {
+    *out_ms = ms;
+  }
+  return ms;
+}
+
+bool clock_is_24h_style(void) {
+  return true;
+}
+
+// Zdroje
+
+typedef struct {
+  uint32_t id;
+  uint8_t *data;
+  size_t size;
+  GSize image_size;
+} Resource;
+
+static Resource resources[RESOURCE_ENTRIES];
+static const Resource missing_resource;
+
+bool stub_resource_file(uint32_t resource_id, const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    return false;
+  }
+  Resource *resource = NULL;
+  for (int i = 0; i < RESOURCE_ENTRIES && !resource; i++) {
+    if (resources[i].id == 0 || resources[i].id == resource_id) {
+      resource = &resources[i];
+    }
+  }
+  if (!resource) {
+    fclose(f);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  resource->id = resource_id;
+  resource->data = realloc(resource->data, size);
+  resource->size = fread(resource->data, 1, size, f);
+  fclose(f);
+  // rozměry z hlavičky IHDR
+  if (resource->size >= 24 && memcmp(resource->data, "\x89PNG", 4) == 0) {
+    const uint8_t *ihdr = resource->data + 16;
+    resource->image_size = GSize(ihdr[2] << 8 | ihdr[3], ihdr[6] << 8 | ihdr[7]);
+  }
+  return true;
+}
+
+static const Resource *resource_find(uint32_t resource_id) {
+  for (int i = 0; i < RESOURCE_ENTRIES; i++) {
+    if (resources[i].id == resource_id) {
+      return &resources[i];
+    }
+  }
+  return &missing_resource;
+}
+
+ResHandle resource_get_handle(uint32_t resource_id) {
+  return resource_find(resource_id);
+}
+
+size_t resource_size(ResHandle h) {
+  return ((const Resource *)h)->size;
+}
+
+size_t resource_load_byte_range(ResHandle h, uint32_t start_offset, uint8_t *buffer, size_t num_bytes) {
+  const Resource *resource = h;
+  stub_counters.resource_reads++;
+  if (start_offset >= resource->size) {
+    return 0;
+  }
+  if (num_bytes > resource->size - start_offset) {
+    num_bytes = resource->size - start_offset;
+  }
+  memcpy(buffer, resource->data + start_offset, num_bytes);
+  return num_bytes;
+}
+
+// Persist
+
+typedef struct {
+  bool used;
+  uint32_t key;
+  uint16_t size;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistEntry;
+
+static PersistEntry persist[PERSIST_ENTRIES];
+
+static PersistEntry *persist_find(uint32_t key, bool create) {
+  PersistEntry *free_entry = NULL;
+  for (int i = 0; i < PERSIST_ENTRIES; i++) {
+    if (persist[i].used && persist[i].key == key) {
+      return &persist[i];
+    }
+    if (!persist[i].used && !free_entry) {
+      free_entry = &persist[i];
+    }
+  }
+  if (create && free_entry) {
+    free_entry->used = true;
+    free_entry->key = key;
+    return free_entry;
+  }
+  return NULL;
+}
+
+bool persist_exists(uint32_t key) {
+  return persist_find(key, false) != NULL;
+}
+
+int persist_read_data(uint32_t key, void *buffer, size_t buffer_size) {
+  PersistEntry *entry = persist_find(key, false);
+  if (!entry) {
+    return E_DOES_NOT_EXIST;
+  }
+  size_t size = entry->size < buffer_size ? entry->size : buffer_size;
+  memcpy(buffer, entry->data, size);
+  return size;
+}
+
+int32_t persist_read_int(uint32_t key) {
+  int32_t value = 0;
+  persist_read_data(key, &value, sizeof(value));
+  return value;
+}
+
+bool persist_read_bool(uint32_t key) {
+  return persist_read_int(key) != 0;
+}
+
+int persist_write_data(uint32_t key, const void *data, size_t size) {
+  PersistEntry *entry = persist_find(key, true);
+  if (!entry) {
+    return E_DOES_NOT_EXIST;
+  }
+  if (size > PERSIST_DATA_MAX_LENGTH) {
+    size = PERSIST_DATA_MAX_LENGTH;
+  }
+  memcpy(entry->data, data, size);
+  entry->size = size;
+  stub_counters.persist_writes++;
+  return size;
+}
+
+int persist_write_int(uint32_t key, int32_t value) {
+  return persist_write_data(key, &value, sizeof(value));
+}
+
+int persist_write_bool(uint32_t key, bool value) {
+  return persist_write_int(key, value);
+}
+
+// Bitmapy, rámec obrazovky je v 8bitovém formátu jako na Basaltu
+
+struct GBitmap {
+  GBitmapFormat format;
+  GRect bounds;
+  uint16_t bytes_per_row;
+  uint8_t *data;
+  bool owns_data;
+};
+
+static uint8_t frame_buffer_data[144 * 168];
+static GBitmap frame_buffer = {
+  GBitmapFormat8Bit, {{0, 0}, {144, 168}}, 144, frame_buffer_data, false
+};
+
+static GBitmap *bitmap_create(GSize size, GBitmapFormat format) {
+  GBitmap *bitmap = stub_calloc(1, sizeof(GBitmap));
+  if (!bitmap) {
+    return NULL;
+  }
+  bitmap->format = format;
+  bitmap->bounds = GRect(0, 0, size.w, size.h);
+  // 1bitové řádky jsou zarovnané na 32 bitů
+  bitmap->bytes_per_row = format == GBitmapFormat1Bit ? (size.w + 31) / 32 * 4 : size.w;
+  bitmap->data = stub_calloc(1, bitmap->bytes_per_row * size.h);
+  bitmap->owns_data = true;
+  return bitmap;
+}
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id) {
+  const Resource *resource = resource_find(resource_id);
+  if (resource->image_size.w == 0) {
+    return NULL;
+  }
+  stub_counters.resource_reads++;
+  return bitmap_create(resource->image_size, GBitmapFormat8Bit);
+}
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format) {
+  return bitmap_create(size, format);
+}
+
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap, GRect sub_rect) {
+  GBitmap *bitmap = stub_calloc(1, sizeof(GBitmap));
+  if (!bitmap) {
+    return NULL;
+  }
+  *bitmap = *base_bitmap;
+  bitmap->bounds = sub_rect;
+  bitmap->owns_data = false;
+  return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+  if (bitmap->owns_data) {
+    stub_free(bitmap->data);
+  }
+  stub_free(bitmap);
+}
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap) {
+  return bitmap->data;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap) {
+  return bitmap->bytes_per_row;
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap) {
+  return bitmap->format;
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap) {
+  return bitmap->bounds;
+}
+
+void gbitmap_set_bounds(GBitmap *bitmap, GRect bounds) {
+  bitmap->bounds = bounds;
+}
+
+// Kreslení se jen počítá
+
+struct GContext {
+  GColor fill_color;
+  GColor stroke_color;
+  GColor text_color;
+};
+
+static GContext context;
+
+GFont fonts_get_system_font(const char *font_key) {
+  return (GFont)font_key;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+  ctx->fill_color = color;
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+  ctx->stroke_color = color;
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+  ctx->text_color = color;
+}
+
+void graphics_draw_pixel(GContext *ctx, GPoint point) {
+  stub_counters.shape_draws++;
+}
+
+void graphics_draw_rect(GContext *ctx, GRect rect) {
+  stub_counters.shape_draws++;
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+  stub_counters.shape_draws++;
+}
+
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect) {
+  stub_counters.bitmap_draws++;
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, GFont font, GRect box, GTextOverflowMode overflow_mode,
+                        GTextAlignment alignment, GTextAttributes *text_attributes) {
+  stub_counters.text_draws++;
+}
+
+// Šířka 10 px na znak stačí pro rozvržení znaků v cache číslic
+GSize graphics_text_layout_get_content_size(const char *text, GFont font, GRect box,
+                                            GTextOverflowMode overflow_mode, GTextAlignment alignment) {
+  int width = 10 * strlen(text);
+  return GSize(width < box.size.w ? width : box.size.w, box.size.h);
+}
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx) {
+  stub_counters.frame_buffer_captures++;
+  return &frame_buffer;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+  return true;
+}
+
+// Vrstvy a okna
+
+struct Layer {
+  GRect frame;
+  LayerUpdateProc update_proc;
+  Layer *children[LAYER_CHILDREN];
+  int child_count;
+};
+
+struct Window {
+  Layer root;
+  WindowHandlers handlers;
+  GColor background_color;
+};
+
+static Window *top_window;
+
+Layer *layer_create(GRect frame) {
+  Layer *layer = stub_calloc(1, sizeof(Layer));
+  if (layer) {
+    layer->frame = frame;
+  }
+  return layer;
+}
+
+void layer_destroy(Layer *layer) {
+  stub_free(layer);
+}
+
+void layer_mark_dirty(Layer *layer) {
+  stub_counters.invalidations++;
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+  layer->update_proc = update_proc;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+  if (parent->child_count < LAYER_CHILDREN) {
+    parent->children[parent->child_count++] = child;
+  }
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+  return GRect(0, 0, layer->frame.size.w, layer->frame.size.h);
+}
+
+static void layer_render(Layer *layer) {
+  if (layer->update_proc) {
+    layer->update_proc(layer, &context);
+  }
+  for (int i = 0; i < layer->child_count; i++) {
+    layer_render(layer->children[i]);
+  }
+}
+
+void stub_render(void) {
+  if (top_window) {
+    layer_render(&top_window->root);
+  }
+}
+
+Window *window_create(void) {
+  Window *window = stub_calloc(1, sizeof(Window));
+  if (window) {
+    window->root.frame = GRect(0, 0, 144, 168);
+  }
+  return window;
+}
+
+void window_destroy(Window *window) {
+  stub_free(window);
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+  window->handlers = handlers;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+  window->background_color = background_color;
+}
+
+Layer *window_get_root_layer(const Window *window) {
+  return (Layer *)&window->root;
+}
+
+void window_stack_push(Window *window, bool animated) {
+  top_window = window;
+  if (window->handlers.load) {
+    window->handlers.load(window);
+  }
+}
+
+bool window_stack_remove(Window *window, bool animated) {
+  if (window != top_window) {
+    return false;
+  }
+  if (window->handlers.unload) {
+    window->handlers.unload(window);
+  }
+  top_window = NULL;
+  return true;
+}
+
+void app_event_loop(void) {
+}
+
+// Služby: události posílá přímo benchmark, odběry se jen přijmou
+
+static bool connected = true;
+
+void stub_set_connected(bool value) {
+  connected = value;
+}
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+}
+
+void tick_timer_service_unsubscribe(void) {
+}
+
+BatteryChargeState battery_state_service_peek(void) {
+  return (BatteryChargeState) { .charge_percent = 80, .is_charging = false, .is_plugged = false };
+}
+
+void battery_state_service_subscribe(BatteryStateHandler handler) {
+}
+
+void battery_state_service_unsubscribe(void) {
+}
+
+void accel_tap_service_subscribe(AccelTapHandler handler) {
+}
+
+void accel_tap_service_unsubscribe(void) {
+}
+
+bool connection_service_peek_pebble_app_connection(void) {
+  return connected;
+}
+
+void connection_service_subscribe(ConnectionHandlers conn_handlers) {
+}
+
+void connection_service_unsubscribe(void) {
+}
+
+HealthActivityMask health_service_peek_current_activities(void) {
+  return HealthActivityNone;
+}
+
+// Časovače nikdy nevyprší, stačí platný ukazatel
+static uint8_t timer_handles[1];
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+  stub_counters.timers++;
+  return (AppTimer *)timer_handles;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+}
+
+// Worker v náhradě neběží
+
+bool app_worker_is_running(void) {
+  return false;
+}
+
+AppWorkerResult app_worker_launch(void) {
+  return APP_WORKER_RESULT_SUCCESS;
+}
+
+AppWorkerResult app_worker_kill(void) {
+  return APP_WORKER_RESULT_NOT_RUNNING;
+}
+
+AppWorkerResult app_worker_send_message(uint8_t type, AppWorkerMessage *message) {
+  return APP_WORKER_RESULT_NOT_RUNNING;
+}
+
+// Slovníky ve formátu firmwaru: počet položek, pak položky klíč, typ, délka, hodnota
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...) {
+  uint32_t size = sizeof(Dictionary) + tuple_count * sizeof(Tuple);
+  va_list sizes;
+  va_start(sizes, tuple_count);
+  for (int i = 0; i < tuple_count; i++) {
+    size += va_arg(sizes, uint32_t);
+  }
+  va_end(sizes);
+  return size;
+}
+
+DictionaryResult dict_write_begin(DictionaryIterator *iter, uint8_t *const buffer, const uint16_t size) {
+  if (size < sizeof(Dictionary)) {
+    return DICT_NOT_ENOUGH_STORAGE;
+  }
+  iter->dictionary = (Dictionary *)buffer;
+  iter->dictionary->count = 0;
+  iter->cursor = iter->dictionary->head;
+  iter->end = buffer + size;
+  return DICT_OK;
+}
+
+static DictionaryResult dict_write(DictionaryIterator *iter, uint32_t key, TupleType type, const void *data,
+                                   uint16_t size) {
+  if ((uint8_t *)iter->cursor + sizeof(Tuple) + size > (const uint8_t *)iter->end) {
+    return DICT_NOT_ENOUGH_STORAGE;
+  }
+  iter->cursor->key = key;
+  iter->cursor->type = type;
+  iter->cursor->length = size;
+  memcpy(iter->cursor->value->data, data, size);
+  iter->cursor = (Tuple *)((uint8_t *)iter->cursor + sizeof(Tuple) + size);
+  iter->dictionary->count++;
+  return DICT_OK;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t *const data,
+                                 const uint16_t size) {
+  return dict_write(iter, key, TUPLE_BYTE_ARRAY, data, size);
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value) {
+  return dict_write(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value) {
+  return dict_write(iter, key, TUPLE_INT, &value, sizeof(value));
+}
+
+uint32_t dict_write_end(DictionaryIterator *iter) {
+  iter->end = iter->cursor;
+  return (uint8_t *)iter->cursor - (uint8_t *)iter->dictionary;
+}
+
+Tuple *dict_read_begin_from_buffer(DictionaryIterator *iter, const uint8_t *const buffer, const uint16_t size) {
+  iter->dictionary = (Dictionary *)buffer;
+  iter->end = buffer + size;
+  return dict_read_first(iter);
+}
+
+Tuple *dict_read_first(DictionaryIterator *iter) {
+  iter->cursor = iter->dictionary->head;
+  return iter->dictionary->count > 0 ? iter->cursor : NULL;
+}
+
+Tuple *dict_read_next(DictionaryIterator *iter) {
+  Tuple *next = (Tuple *)((uint8_t *)iter->cursor + sizeof(Tuple) + iter->cursor->length);
+  if ((const uint8_t *)next + sizeof(Tuple) > (const uint8_t *)iter->end) {
+    return NULL;
+  }
+  iter->cursor = next;
+  return next;
+}
+
+// AppMessage: buffery alokuje firmware na haldě aplikace, odeslaná zpráva čeká na stub_outbox_ack()
+
+static AppMessageOutboxSent outbox_sent;
+static AppMessageOutboxFailed outbox_failed;
+static uint8_t *inbox;
+static uint8_t *outbox;
+static uint32_t inbox_size;
+static uint32_t outbox_size;
+static DictionaryIterator outbox_iter;
+static bool outbox_writing;
+static bool outbox_pending;
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+  inbox = stub_malloc(size_inbound);
+  outbox = stub_malloc(size_outbound);
+  if (!inbox || !outbox) {
+    return APP_MSG_OUT_OF_MEMORY;
+  }
+  inbox_size = size_inbound;
+  outbox_size = size_outbound;
+  return APP_MSG_OK;
+}
+
+uint32_t stub_inbox_size(void) {
+  return inbox_size;
+}
+
+uint32_t stub_outbox_size(void) {
+  return outbox_size;
+}
+
+void app_message_register_inbox_received(AppMessageInboxReceived received_callback) {
+}
+
+void app_message_register_outbox_sent(AppMessageOutboxSent sent_callback) {
+  outbox_sent = sent_callback;
+}
+
+void app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback) {
+  outbox_failed = failed_callback;
+}
+
+void app_message_deregister_callbacks(void) {
+  outbox_sent = NULL;
+  outbox_failed = NULL;
+  stub_free(inbox);
+  stub_free(outbox);
+  inbox = outbox = NULL;
+  inbox_size = outbox_size = 0;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+  if (outbox_pending || outbox_writing) {
+    return APP_MSG_BUSY;
+  }
+  if (!outbox) {
+    return APP_MSG_INVALID_ARGS;
+  }
+  dict_write_begin(&outbox_iter, outbox, outbox_size);
+  outbox_writing = true;
+  *iterator = &outbox_iter;
+  return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+  if (!outbox_writing) {
+    return APP_MSG_INVALID_ARGS;
+  }
+  outbox_writing = false;
+  if (!connected) {
+    return APP_MSG_NOT_CONNECTED;
+  }
+  outbox_pending = true;
+  stub_counters.messages_sent++;
+  return APP_MSG_OK;
+}
+
+bool stub_outbox_ack(void) {
+  if (!outbox_pending) {
+    return false;
+  }
+  outbox_pending = false;
+  if (outbox_sent) {
+    outbox_sent(&outbox_iter, NULL);
+  }
+  return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <pebble.h>
+
+// Co ciferník od posledního stub_reset() zavolal
+typedef struct {
+  // malloc/calloc/realloc a objekty SDK, které firmware alokuje na haldě aplikace
+  uint32_t allocations;
+  uint32_t frees;
+  // layer_mark_dirty
+  uint32_t invalidations;
+  uint32_t text_draws;
+  uint32_t bitmap_draws;
+  // obdélníky a body
+  uint32_t shape_draws;
+  uint32_t frame_buffer_captures;
+  uint32_t resource_reads;
+  uint32_t persist_writes;
+  uint32_t messages_sent;
+  uint32_t timers;
+  uint32_t logs;
+} StubCounters;
+
+extern StubCounters stub_counters;
+
+void stub_reset(void);
+// Bajty alokované ciferníkem, které ještě nebyly uvolněny
+size_t stub_heap_in_use(void);
+// Obsah zdroje se načte ze souboru, PNG určí i rozměry bitmapy
+bool stub_resource_file(uint32_t resource_id, const char *path);
+void stub_set_connected(bool connected);
+// Potvrdí odeslanou zprávu jako telefon, vrací false, pokud žádná nečeká
+bool stub_outbox_ack(void);
+// Velikosti bufferů z app_message_open()
+uint32_t stub_inbox_size(void);
+uint32_t stub_outbox_size(void);
+// Vykreslí okno na vrcholu zásobníku jako firmware
+void stub_render(void);
+// Logy ciferníku se vypisují na stderr, jinak se jen počítají
+void stub_set_verbose(bool verbose);
@@ -0,0 +1,361 @@
+#pragma once
+// Náhrada pebble.h pro sestavení ciferníku na počítači (tools/bench). Obsahuje jen to, co
+// ciferník používá, s typy a hodnotami podle SDK 3. Implementace je v pebble-stub.c, volání
+// vrstev, textu a bitmap zaznamenává a alokace počítá, viz pebble-stub.h.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "resource_ids.auto.h"
+
+// Alokace ciferníku jdou přes počítadlo v pebble-stub.c
+#if !defined(PEBBLE_STUB_IMPLEMENTATION)
+void *stub_malloc(size_t size);
+void *stub_calloc(size_t count, size_t size);
+void *stub_realloc(void *ptr, size_t size);
+void stub_free(void *ptr);
+#define malloc stub_malloc
+#define calloc stub_calloc
+#define realloc stub_realloc
+#define free stub_free
+#endif
+
+#define SECONDS_PER_MINUTE 60
+#define SECONDS_PER_HOUR 3600
+#define SECONDS_PER_DAY 86400
+#define ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+// Logování
+
+typedef enum {
+  APP_LOG_LEVEL_ERROR = 1,
+  APP_LOG_LEVEL_WARNING = 50,
+  APP_LOG_LEVEL_INFO = 100,
+  APP_LOG_LEVEL_DEBUG = 200,
+  APP_LOG_LEVEL_DEBUG_VERBOSE = 255
+} AppLogLevel;
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+#define APP_LOG(level, fmt, args...) app_log(level, __FILE__, __LINE__, fmt, ## args)
+
+// Geometrie a barvy
+
+typedef struct {
+  int16_t x;
+  int16_t y;
+} GPoint;
+
+typedef struct {
+  int16_t w;
+  int16_t h;
+} GSize;
+
+typedef struct {
+  GPoint origin;
+  GSize size;
+} GRect;
+
+#define GPoint(x, y) ((GPoint) {(x), (y)})
+#define GSize(w, h) ((GSize) {(w), (h)})
+#define GRect(x, y, w, h) ((GRect) {{(x), (y)}, {(w), (h)}})
+
+typedef union {
+  uint8_t argb;
+} GColor8;
+typedef GColor8 GColor;
+
+#define GColorClear ((GColor8) {.argb = 0x00})
+#define GColorBlack ((GColor8) {.argb = 0xc0})
+#define GColorWhite ((GColor8) {.argb = 0xff})
+
+typedef enum {
+  GTextAlignmentLeft,
+  GTextAlignmentCenter,
+  GTextAlignmentRight
+} GTextAlignment;
+
+typedef enum {
+  GTextOverflowModeWordWrap,
+  GTextOverflowModeTrailingEllipsis,
+  GTextOverflowModeFill
+} GTextOverflowMode;
+
+typedef enum {
+  GCornerNone = 0,
+  GCornersAll = 0xff
+} GCornerMask;
+
+typedef enum {
+  GBitmapFormat1Bit,
+  GBitmapFormat8Bit,
+  GBitmapFormat1BitPalette,
+  GBitmapFormat2BitPalette,
+  GBitmapFormat4BitPalette,
+  GBitmapFormat8BitCircular
+} GBitmapFormat;
+
+typedef struct GBitmap GBitmap;
+typedef struct GContext GContext;
+typedef struct GTextAttributes GTextAttributes;
+typedef struct Layer Layer;
+typedef struct Window Window;
+typedef const struct FontInfo *GFont;
+
+// Systémová písma, v náhradě jen názvy
+#define FONT_KEY_BITHAM_42_BOLD "RESOURCE_ID_BITHAM_42_BOLD"
+#define FONT_KEY_GOTHIC_14 "RESOURCE_ID_GOTHIC_14"
+#define FONT_KEY_GOTHIC_18 "RESOURCE_ID_GOTHIC_18"
+#define FONT_KEY_GOTHIC_18_BOLD "RESOURCE_ID_GOTHIC_18_BOLD"
+#define FONT_KEY_GOTHIC_24 "RESOURCE_ID_GOTHIC_24"
+#define FONT_KEY_GOTHIC_24_BOLD "RESOURCE_ID_GOTHIC_24_BOLD"
+
+GFont fonts_get_system_font(const char *font_key);
+
+// Bitmapy
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id);
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format);
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap, GRect sub_rect);
+void gbitmap_destroy(GBitmap *bitmap);
+uint8_t *gbitmap_get_data(const GBitmap *bitmap);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap);
+GRect gbitmap_get_bounds(const GBitmap *bitmap);
+void gbitmap_set_bounds(GBitmap *bitmap, GRect bounds);
+
+// Kreslení
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_text_color(GContext *ctx, GColor color);
+void graphics_draw_pixel(GContext *ctx, GPoint point);
+void graphics_draw_rect(GContext *ctx, GRect rect);
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect);
+void graphics_draw_text(GContext *ctx, const char *text, GFont font, GRect box, GTextOverflowMode overflow_mode,
+                        GTextAlignment alignment, GTextAttributes *text_attributes);
+GSize graphics_text_layout_get_content_size(const char *text, GFont font, GRect box,
+                                            GTextOverflowMode overflow_mode, GTextAlignment alignment);
+GBitmap *graphics_capture_frame_buffer(GContext *ctx);
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer);
+
+// Vrstvy a okna
+
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+Layer *layer_create(GRect frame);
+void layer_destroy(Layer *layer);
+void layer_mark_dirty(Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_add_child(Layer *parent, Layer *child);
+GRect layer_get_bounds(const Layer *layer);
+
+typedef void (*WindowHandler)(Window *window);
+
+typedef struct {
+  WindowHandler load;
+  WindowHandler appear;
+  WindowHandler disappear;
+  WindowHandler unload;
+} WindowHandlers;
+
+Window *window_create(void);
+void window_destroy(Window *window);
+void window_set_window_handlers(Window *window, WindowHandlers handlers);
+void window_set_background_color(Window *window, GColor background_color);
+Layer *window_get_root_layer(const Window *window);
+void window_stack_push(Window *window, bool animated);
+bool window_stack_remove(Window *window, bool animated);
+
+void app_event_loop(void);
+
+// Služby
+
+typedef enum {
+  SECOND_UNIT = 1 << 0,
+  MINUTE_UNIT = 1 << 1,
+  HOUR_UNIT = 1 << 2,
+  DAY_UNIT = 1 << 3,
+  MONTH_UNIT = 1 << 4,
+  YEAR_UNIT = 1 << 5
+} TimeUnits;
+
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+
+typedef struct {
+  uint8_t charge_percent;
+  bool is_charging;
+  bool is_plugged;
+} BatteryChargeState;
+
+typedef void (*BatteryStateHandler)(BatteryChargeState charge);
+
+BatteryChargeState battery_state_service_peek(void);
+void battery_state_service_subscribe(BatteryStateHandler handler);
+void battery_state_service_unsubscribe(void);
+
+typedef enum {
+  ACCEL_AXIS_X = 0,
+  ACCEL_AXIS_Y = 1,
+  ACCEL_AXIS_Z = 2
+} AccelAxisType;
+
+typedef void (*AccelTapHandler)(AccelAxisType axis, int32_t direction);
+
+void accel_tap_service_subscribe(AccelTapHandler handler);
+void accel_tap_service_unsubscribe(void);
+
+typedef void (*ConnectionHandler)(bool connected);
+
+typedef struct {
+  ConnectionHandler pebble_app_connection_handler;
+  ConnectionHandler pebblekit_connection_handler;
+} ConnectionHandlers;
+
+bool connection_service_peek_pebble_app_connection(void);
+void connection_service_subscribe(ConnectionHandlers conn_handlers);
+void connection_service_unsubscribe(void);
+
+typedef enum {
+  HealthActivityNone = 0,
+  HealthActivitySleep = 1 << 0,
+  HealthActivityRestfulSleep = 1 << 1
+} HealthActivity;
+typedef uint32_t HealthActivityMask;
+
+HealthActivityMask health_service_peek_current_activities(void);
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data);
+void app_timer_cancel(AppTimer *timer_handle);
+
+bool clock_is_24h_style(void);
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms);
+size_t heap_bytes_used(void);
+size_t heap_bytes_free(void);
+
+// Zdroje a persist
+
+typedef const void *ResHandle;
+
+ResHandle resource_get_handle(uint32_t resource_id);
+size_t resource_size(ResHandle h);
+size_t resource_load_byte_range(ResHandle h, uint32_t start_offset, uint8_t *buffer, size_t num_bytes);
+
+bool persist_exists(uint32_t key);
+bool persist_read_bool(uint32_t key);
+int32_t persist_read_int(uint32_t key);
+int persist_read_data(uint32_t key, void *buffer, size_t buffer_size);
+int persist_write_bool(uint32_t key, bool value);
+int persist_write_int(uint32_t key, int32_t value);
+int persist_write_data(uint32_t key, const void *data, size_t size);
+
+// Slovníky a AppMessage
+
+typedef enum {
+  TUPLE_BYTE_ARRAY = 0,
+  TUPLE_CSTRING = 1,
+  TUPLE_UINT = 2,
+  TUPLE_INT = 3
+} TupleType;
+
+typedef struct __attribute__((packed)) {
+  uint32_t key;
+  TupleType type:8;
+  uint16_t length;
+  union {
+    uint8_t data[0];
+    char cstring[0];
+    uint8_t uint8;
+    uint16_t uint16;
+    uint32_t uint32;
+    int8_t int8;
+    int16_t int16;
+    int32_t int32;
+  } value[];
+} Tuple;
+
+typedef struct __attribute__((packed)) {
+  uint8_t count;
+  Tuple head[];
+} Dictionary;
+
+typedef struct {
+  Dictionary *dictionary;
+  const void *end;
+  Tuple *cursor;
+} DictionaryIterator;
+
+typedef enum {
+  DICT_OK = 0,
+  DICT_NOT_ENOUGH_STORAGE = 1 << 1,
+  DICT_INVALID_ARGS = 1 << 2
+} DictionaryResult;
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...);
+DictionaryResult dict_write_begin(DictionaryIterator *iter, uint8_t *const buffer, const uint16_t size);
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t *const data,
+                                 const uint16_t size);
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value);
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value);
+uint32_t dict_write_end(DictionaryIterator *iter);
+Tuple *dict_read_begin_from_buffer(DictionaryIterator *iter, const uint8_t *const buffer, const uint16_t size);
+Tuple *dict_read_first(DictionaryIterator *iter);
+Tuple *dict_read_next(DictionaryIterator *iter);
+
+typedef enum {
+  APP_MSG_OK = 0,
+  APP_MSG_SEND_TIMEOUT = 1 << 1,
+  APP_MSG_SEND_REJECTED = 1 << 2,
+  APP_MSG_NOT_CONNECTED = 1 << 3,
+  APP_MSG_APP_NOT_RUNNING = 1 << 4,
+  APP_MSG_INVALID_ARGS = 1 << 5,
+  APP_MSG_BUSY = 1 << 6,
+  APP_MSG_BUFFER_OVERFLOW = 1 << 7,
+  APP_MSG_OUT_OF_MEMORY = 1 << 10
+} AppMessageResult;
+
+typedef void (*AppMessageInboxReceived)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageOutboxSent)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageOutboxFailed)(DictionaryIterator *iterator, AppMessageResult reason, void *context);
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound);
+void app_message_register_inbox_received(AppMessageInboxReceived received_callback);
+void app_message_register_outbox_sent(AppMessageOutboxSent sent_callback);
+void app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback);
+void app_message_deregister_callbacks(void);
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator);
+AppMessageResult app_message_outbox_send(void);
+
+// Worker na pozadí
+
+typedef enum {
+  APP_WORKER_RESULT_SUCCESS = 0,
+  APP_WORKER_RESULT_NO_WORKER = 1,
+  APP_WORKER_RESULT_DIFFERENT_APP = 2,
+  APP_WORKER_RESULT_NOT_RUNNING = 3,
+  APP_WORKER_RESULT_ALREADY_RUNNING = 4,
+  APP_WORKER_RESULT_ASKING_CONFIRMATION = 5
+} AppWorkerResult;
+
+typedef struct {
+  uint16_t data0;
+  uint16_t data1;
+  uint16_t data2;
+} AppWorkerMessage;
+
+bool app_worker_is_running(void);
+AppWorkerResult app_worker_launch(void);
+AppWorkerResult app_worker_kill(void);
+AppWorkerResult app_worker_send_message(uint8_t type, AppWorkerMessage *message);
@@ -0,0 +1,24 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# Generuje resource_ids.auto.h pro sestavení na počítači (tools/bench), čísla
+# zdrojů jsou ve stejném pořadí jako v appinfo.json, jak je přiděluje SDK.
+#
+# Použití: resource_ids.py <appinfo.json> <výstup.h>
+
+import io
+import json
+import sys
+
+
+def generate(appinfo, header):
+    with io.open(appinfo, encoding='utf-8') as f:
+        media = json.load(f)['resources']['media']
+    lines = [u'// Vygenerováno nástrojem tools/bench/resource_ids.py, neupravovat.', u'#pragma once', u'']
+    lines += [u'#define RESOURCE_ID_%s %d' % (item['name'], number) for number, item in enumerate(media, 1)]
+    with io.open(header, 'w', encoding='utf-8') as f:
+        f.write(u'\n'.join(lines) + u'\n')
+
+
+if __name__ == '__main__':
+    generate(sys.argv[1], sys.argv[2])
@@ -0,0 +1,151 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# Generuje binární jazykovou sadu pro locale-pack.c z textového souboru.
+#
+# Vstup: sekce [labels], [weekdays], [months], [holidays] a [namedays], popis
+# formátu je v hlavičce resources/locales/cs.txt. Řádky začínající '#' a prázdné
+# řádky se ignorují.
+#
+# Výstup (little endian, offsety od začátku souboru):
+#   hlavička  uint8 verze, uint8 počet svátků, uint16 offset svátků,
+#             uint16 offset indexu jmen, uint16 popisky[2], dny[7], měsíce[12]
+#   svátky    uint8 druh (0 pevný, 1 od Velikonoc), uint8 rezerva, int16 den,
+#             uint16 platí od roku (0 = vždy), uint16 název (0xffff = bez názvu)
+#   jména     uint16 offset řetězce pro každý ze 366 dní přestupného roku
+#   pool      řetězce UTF-8 ukončené '\0', shodná jména a konce jmen se sdílejí
+#
+# Použití: locale_pack.py <vstup.txt> <výstup.bin>
+
+import datetime
+import io
+import re
+import struct
+import sys
+
+VERSION = 1
+DAYS = 366
+COUNTS = {'labels': 2, 'weekdays': 7, 'months': 12}
+HEADER = struct.Struct('<BBHH2H7H12H')
+HOLIDAY = struct.Struct('<BBhHH')
+HOLIDAY_FIXED = 0
+HOLIDAY_EASTER = 1
+NO_NAME = 0xffff
+# Nejvýše tolik bajtů včetně '\0', musí odpovídat LOCALE_*_SIZE v src/locale-pack.h
+NAMEDAY_SIZE = 40
+HOLIDAY_SIZE = 24
+HOLIDAY_LINE = re.compile(r'^(\d\d-\d\d|easter[+-]\d+)(?:\s+(\d{4}))?(?:\s+(.*))?$')
+
+
+def leap_index(key):
+    """Index dne MM-DD v přestupném roce."""
+    month, day = int(key[:2]), int(key[3:])
+    return (datetime.date(2016, month, day) - datetime.date(2016, 1, 1)).days
+
+
+def read_sections(path):
+    sections = {}
+    current = None
+    with io.open(path, encoding='utf-8') as f:
+        for number, line in enumerate(f, 1):
+            line = line.rstrip('\r\n')
+            if not line.strip() or line.startswith('#'):
+                continue
+            if line.startswith('[') and line.endswith(']'):
+                current = line[1:-1]
+                sections[current] = []
+            elif current is None:
+                raise ValueError('%s:%d: řádek mimo sekci' % (path, number))
+            else:
+                sections[current].append((number, line))
+    return sections
+
+
+def parse_namedays(path, lines):
+    names = []
+    day = datetime.date(2016, 1, 1)
+    for number, line in lines:
+        key, _, name = line.partition(' ')
+        expected = '%02d-%02d' % (day.month, day.day)
+        if key != expected:
+            raise ValueError('%s:%d: očekáváno %s, nalezeno %s' % (path, number, expected, key))
+        name = name.strip().encode('utf-8')
+        if len(name) >= NAMEDAY_SIZE:
+            raise ValueError('%s:%d: jméno je delší než %d bajtů' % (path, number, NAMEDAY_SIZE - 1))
+        names.append(name)
+        day += datetime.timedelta(days=1)
+    if len(names) != DAYS:
+        raise ValueError('%s: očekáváno %d dní, nalezeno %d' % (path, DAYS, len(names)))
+    return names
+
+
+def parse_holidays(path, lines):
+    holidays = []
+    for number, line in lines:
+        match = HOLIDAY_LINE.match(line.strip())
+        if not match:
+            raise ValueError('%s:%d: neplatný svátek: %s' % (path, number, line))
+        day, since, name = match.groups()
+        if day.startswith('easter'):
+            kind, day = HOLIDAY_EASTER, int(day[6:])
+        else:
+            kind, day = HOLIDAY_FIXED, leap_index(day)
+        name = name.strip().encode('utf-8') if name else None
+        if name and len(name) >= HOLIDAY_SIZE:
+            raise ValueError('%s:%d: název svátku je delší než %d bajtů' % (path, number, HOLIDAY_SIZE - 1))
+        holidays.append((kind, day, int(since or 0), name))
+    return holidays
+
+
+def pack(names):
+    """Vrátí (pool, {jméno: offset}), delší řetězce se umisťují první, aby kratší mohly sdílet jejich konec."""
+    pool = b''
+    placed = {}
+    for name in sorted(set(names), key=lambda name: (-len(name), name)):
+        for other in pool.split(b'\0'):
+            if other.endswith(name):
+                placed[name] = pool.index(other + b'\0') + len(other) - len(name)
+                break
+        else:
+            placed[name] = len(pool)
+            pool += name + b'\0'
+    return pool, placed
+
+
+def generate(source, target):
+    sections = read_sections(source)
+    strings = {}
+    for section, count in sorted(COUNTS.items()):
+        values = [line.strip().encode('utf-8') for _, line in sections.get(section, [])]
+        if len(values) != count:
+            raise ValueError('%s: sekce [%s] má mít %d řádků, má %d' % (source, section, count, len(values)))
+        strings[section] = values
+    holidays = parse_holidays(source, sections.get('holidays', []))
+    names = parse_namedays(source, sections.get('namedays', []))
+
+    all_strings = names + [name for _, _, _, name in holidays if name]
+    for section in COUNTS:
+        all_strings += strings[section]
+    pool, placed = pack(all_strings)
+
+    holidays_offset = HEADER.size
+    namedays_offset = holidays_offset + HOLIDAY.size * len(holidays)
+    pool_offset = namedays_offset + 2 * DAYS
+    if pool_offset + len(pool) > 0xffff:
+        raise ValueError('jazyková sada je větší než 64 kB')
+
+    def offset(name):
+        return pool_offset + placed[name]
+
+    data = HEADER.pack(VERSION, len(holidays), holidays_offset, namedays_offset,
+                       *[offset(s) for s in strings['labels'] + strings['weekdays'] + strings['months']])
+    for kind, day, since, name in holidays:
+        data += HOLIDAY.pack(kind, 0, day, since, offset(name) if name else NO_NAME)
+    data += struct.pack('<%dH' % DAYS, *[offset(name) for name in names])
+    data += pool
+    with open(target, 'wb') as f:
+        f.write(data)
+
+
+if __name__ == '__main__':
+    generate(sys.argv[1], sys.argv[2])
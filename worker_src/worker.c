@@ -0,0 +1,59 @@
+#include <pebble_worker.h>
+#include "../src/worker-snapshot.h"
+
+static WorkerSnapshot snapshot;
+
+static void snapshot_save(void) {
+  persist_write_data(WORKER_SNAPSHOT_KEY, &snapshot, sizeof(snapshot));
+}
+
+// Vzorek baterie aktuální hodiny, hodiny od minulého vzorku zůstanou bez hodnoty
+static void battery_sample(void) {
+  uint32_t hour = time(NULL) / SECONDS_PER_HOUR;
+  uint32_t elapsed = hour - snapshot.battery_hour;
+  if (hour < snapshot.battery_hour || elapsed >= WORKER_BATTERY_SAMPLES) {
+    memset(snapshot.battery_samples, WORKER_BATTERY_UNKNOWN, sizeof(snapshot.battery_samples));
+  } else {
+    for (uint32_t h = snapshot.battery_hour + 1; h < hour; h++) {
+      snapshot.battery_samples[h % WORKER_BATTERY_SAMPLES] = WORKER_BATTERY_UNKNOWN;
+    }
+  }
+  snapshot.battery_hour = hour;
+  snapshot.battery_samples[hour % WORKER_BATTERY_SAMPLES] = battery_state_service_peek().charge_percent;
+}
+
+// Ukládá se jen jednou za hodinu, ne při každé změně baterie
+static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
+  battery_sample();
+  snapshot_save();
+}
+
+static void message_handler(uint16_t type, AppWorkerMessage *message) {
+  if (type == WORKER_MESSAGE_WEATHER_DUE) {
+    snapshot.weather_due = message->data0 | (uint32_t)message->data1 << 16;
+    snapshot_save();
+  }
+}
+
+static void init(void) {
+  if (persist_read_data(WORKER_SNAPSHOT_KEY, &snapshot, sizeof(snapshot)) != sizeof(snapshot) ||
+      snapshot.version != WORKER_SNAPSHOT_VERSION) {
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.version = WORKER_SNAPSHOT_VERSION;
+  }
+  battery_sample();
+  tick_timer_service_subscribe(HOUR_UNIT, tick_handler);
+  app_worker_message_subscribe(message_handler);
+}
+
+static void deinit(void) {
+  app_worker_message_unsubscribe();
+  tick_timer_service_unsubscribe();
+  snapshot_save();
+}
+
+int main(void) {
+  init();
+  worker_event_loop();
+  deinit();
+}